@@ -4,10 +4,13 @@ in VS_OUT
 {
     vec3 normal;
     vec2 uv;
+    flat uint layer;
     float light;
 } fs;
 
-uniform sampler2D uAtlas;
+// One layer per block tile with GL_REPEAT wrapping: UVs are in tile units, so greedy-merged
+// quads tile their texture instead of stretching across the atlas.
+uniform sampler2DArray uBlockTextures;
 uniform vec3 uLightDir;
 
 out vec4 FragColor;
@@ -17,6 +20,6 @@ void main()
     vec3 lightDir = normalize(-uLightDir);
     float nDotL = max(dot(normalize(fs.normal), lightDir), 0.1);
     float shading = nDotL * fs.light;
-    vec4 albedo = texture(uAtlas, fs.uv);
+    vec4 albedo = texture(uBlockTextures, vec3(fs.uv, float(fs.layer)));
     FragColor = vec4(albedo.rgb * shading, albedo.a);
 }
@@ -4,6 +4,7 @@ layout(location = 0) in vec3 aPosition;
 layout(location = 1) in uint aNormal;
 layout(location = 2) in vec2 aUV;
 layout(location = 3) in uint aLight;
+layout(location = 4) in uint aLayer;
 
 uniform mat4 uProjection;
 uniform mat4 uView;
@@ -13,6 +14,7 @@ out VS_OUT
 {
     vec3 normal;
     vec2 uv;
+    flat uint layer;
     float light;
 } vs;
 
@@ -33,5 +35,6 @@ void main()
     mat3 normalMatrix = mat3(uModel);
     vs.normal = normalize(normalMatrix * decodeNormal(aNormal));
     vs.uv = aUV;
+    vs.layer = aLayer;
     vs.light = float(aLight) / 255.0;
 }
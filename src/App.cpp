@@ -13,6 +13,9 @@
 
 namespace
 {
+// Horizon terrain starts past the voxel chunks, so its pass can afford a distant near plane.
+constexpr float FarTerrainNearPlane = 16.0f;
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     auto* app = static_cast<App*>(glfwGetWindowUserPointer(window));
@@ -23,7 +26,10 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 }
 }
 
-App::App() = default;
+App::App()
+    : m_streamer(&m_meshFactory)
+{
+}
 
 App::~App()
 {
@@ -59,7 +65,7 @@ bool App::initialize()
     }
 
     const auto atlasSettings = config::atlas();
-    if (!m_atlas.load_atlas("assets/atlas.png", atlasSettings.tilesX, atlasSettings.tilesY))
+    if (!m_blockTextures.load_array("assets/atlas.png", atlasSettings.tilesX, atlasSettings.tilesY))
     {
         util::log().error("Failed to load texture atlas. Place atlas.png in assets/");
         return false;
@@ -72,7 +78,7 @@ bool App::initialize()
     }
 
     m_chunkShader.use();
-    m_chunkShader.set_int("uAtlas", 0);
+    m_chunkShader.set_int("uBlockTextures", 0);
 
     glEnable(GL_CULL_FACE);
     glEnable(GL_DEPTH_TEST);
@@ -179,26 +185,78 @@ void App::handle_input(float dt)
         prev = pressed;
     };
 
+    auto handle_click = [&](int button, auto onPress) {
+        static std::unordered_map<int, bool> previous;
+        const bool pressed = glfwGetMouseButton(window, button) == GLFW_PRESS;
+        bool& prev = previous[button];
+        if (pressed && !prev)
+        {
+            onPress();
+        }
+        prev = pressed;
+    };
+
+    const float reach = 8.0f;
+    handle_click(GLFW_MOUSE_BUTTON_LEFT, [&] {
+        if (const auto hit = m_streamer.raycast(m_camera.position(), m_camera.forward(), reach))
+        {
+            m_streamer.set_block(hit->block, world::BlockAir);
+        }
+    });
+    handle_click(GLFW_MOUSE_BUTTON_RIGHT, [&] {
+        if (const auto hit = m_streamer.raycast(m_camera.position(), m_camera.forward(), reach))
+        {
+            m_streamer.set_block(hit->block + hit->normal, m_placeBlock);
+        }
+    });
+
+    // Swap the placed block between stone (3) and glowstone (7).
+    handle_toggle(GLFW_KEY_G, [this] { m_placeBlock = m_placeBlock == 3 ? 7 : 3; });
+
     handle_toggle(GLFW_KEY_F1, [this] { toggle_wireframe(); });
     handle_toggle(GLFW_KEY_F2, [this] { reload_shaders(); });
     handle_toggle(GLFW_KEY_F3, [this] {
         const auto stats = m_streamer.stats();
-        util::log().info("Chunks: total=%zu generating=%zu meshPending=%zu uploaded=%zu meshing=%zu pendingUploads=%zu | jobs gen=%zu mesh=%zu",
+        util::log().info("Chunks: total=%zu covered=%zu (observers %zu) generating=%zu meshPending=%zu uploaded=%zu meshing=%zu pendingUploads=%zu pooledBuffers=%zu farTiles=%zu/%zu | jobs gen=%zu mesh=%zu cancelled=%zu meshWaiting=%zu meshesBuilt=%zu (borders only %zu) retired=%zu | droppedUploads=%zu uploadedKiB=%zu | memory KiB voxels=%zu (sections %zu) cpuMeshes=%zu gpuVertices=%zu gpuIndices=%zu jobs=%zu, cpuDropped=%zu lodsEvicted=%zu chunksEvicted=%zu | warm=%zu (%zu KiB) | disk loaded=%zu writes=%zu",
                          stats.totalChunks,
+                         stats.coveredChunks,
+                         stats.observers,
                          stats.generating,
                          stats.meshPending,
                          stats.uploaded,
                          stats.meshing,
                          stats.pendingUploads,
+                         stats.pooledBuffers,
+                         stats.farTiles,
+                         stats.farTiles + stats.farTilesPending,
                          m_streamer.pending_generation_jobs(),
-                         m_streamer.pending_meshing_jobs());
+                         m_streamer.pending_meshing_jobs(),
+                         stats.cancelledJobs,
+                         stats.meshWaiting,
+                         stats.meshJobs,
+                         stats.borderMeshJobs,
+                         stats.retiredEntries,
+                         stats.droppedUploads,
+                         stats.uploadedBytes / 1024,
+                         stats.memory[static_cast<std::size_t>(world::MemoryCategory::Voxels)] / 1024,
+                         stats.allocatedSections,
+                         stats.memory[static_cast<std::size_t>(world::MemoryCategory::CpuMeshes)] / 1024,
+                         stats.memory[static_cast<std::size_t>(world::MemoryCategory::GpuVertices)] / 1024,
+                         stats.memory[static_cast<std::size_t>(world::MemoryCategory::GpuIndices)] / 1024,
+                         stats.memory[static_cast<std::size_t>(world::MemoryCategory::Jobs)] / 1024,
+                         stats.droppedCpuMeshes,
+                         stats.evictedLods,
+                         stats.evictedChunks,
+                         stats.warmChunks,
+                         stats.warmBytes / 1024,
+                         stats.loadedChunks,
+                         stats.pendingWrites);
     });
 }
 
 void App::update(float dt)
 {
-    (void)dt;
-    m_streamer.update(m_camera.position());
+    m_streamer.update(m_camera.position(), m_camera.forward(), dt);
 }
 
 void App::render()
@@ -214,14 +272,36 @@ void App::render()
     m_streamer.gather_draw_commands(m_camera, frustum, opaque, transparent);
 
     m_chunkShader.use();
-    m_chunkShader.set_mat4("uProjection", m_camera.projection());
     m_chunkShader.set_mat4("uView", m_camera.view());
     m_chunkShader.set_vec3("uLightDir", glm::normalize(glm::vec3(-0.3f, -1.0f, -0.2f)));
-    m_atlas.bind(0);
+    m_blockTextures.bind(0);
 
     glPolygonMode(GL_FRONT_AND_BACK, m_wireframe ? GL_LINE : GL_FILL);
     glDisable(GL_BLEND);
 
+    // Horizon terrain goes first with its own depth range, then depth is cleared: the voxel
+    // area contains the camera, so voxel geometry is always nearer than the horizon.
+    const world::FarTerrain& farTerrain = m_streamer.far_terrain();
+    const glm::mat4 farProjection = m_camera.projection(FarTerrainNearPlane, farTerrain.view_distance());
+    renderer::Frustum farFrustum;
+    farFrustum.update(farProjection * m_camera.view());
+    std::vector<world::FarDrawCommand> farCommands;
+    farTerrain.gather_draw_commands(farFrustum, farCommands);
+    if (!farCommands.empty())
+    {
+        m_chunkShader.set_mat4("uProjection", farProjection);
+        glDisable(GL_CULL_FACE);
+        for (const auto& cmd : farCommands)
+        {
+            m_chunkShader.set_mat4("uModel", glm::translate(glm::mat4(1.0f), cmd.origin));
+            cmd.mesh->draw();
+        }
+        glEnable(GL_CULL_FACE);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    m_chunkShader.set_mat4("uProjection", m_camera.projection());
+
     for (const auto& cmd : opaque)
     {
         const glm::mat4 model = glm::translate(glm::mat4(1.0f), cmd.chunk->world_position());
@@ -249,6 +329,6 @@ void App::reload_shaders()
 {
     m_chunkShader.reload();
     m_chunkShader.use();
-    m_chunkShader.set_int("uAtlas", 0);
+    m_chunkShader.set_int("uBlockTextures", 0);
     m_streamer.reload();
 }
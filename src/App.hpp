@@ -5,6 +5,7 @@
 #include "Renderer/Camera.hpp"
 #include "Renderer/Frustum.hpp"
 #include "Renderer/GLContext.hpp"
+#include "Renderer/Mesh.hpp"
 #include "Renderer/Shader.hpp"
 #include "Renderer/Texture.hpp"
 #include "World/WorldStreamer.hpp"
@@ -34,15 +35,18 @@ class App
 
     renderer::GLContext m_context;
     renderer::Shader m_chunkShader;
-    renderer::Texture m_atlas;
+    renderer::Texture m_blockTextures;
 
     renderer::Camera m_camera;
+    // Creates no GL objects itself, so it and the streamer can exist before the context.
+    renderer::GLMeshFactory m_meshFactory;
     world::WorldStreamer m_streamer;
 
     glm::vec2 m_lastMouse{0.0f};
     bool m_firstMouse = true;
     bool m_wireframe = false;
     bool m_running = true;
+    world::BlockID m_placeBlock = 3; // stone
 
     core::Timer m_frameTimer;
 };
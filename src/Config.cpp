@@ -17,6 +17,16 @@ StreamSettings streaming()
     return {};
 }
 
+MemorySettings memory()
+{
+    return {};
+}
+
+FarTerrainSettings far_terrain()
+{
+    return {};
+}
+
 AtlasSettings atlas()
 {
     return {};
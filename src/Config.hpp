@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -16,6 +17,21 @@ struct NoiseSettings
     float gain = 0.5f;
     float baseHeight = 64.0f;
     float seaLevel = 62.0f;
+    // Temperature / humidity noise driving biome selection (see World/BiomeMap.hpp).
+    float climateFrequency = 0.0008f;
+    // 3D density stage: 3D noise pushes the heightmap surface up or down by as much as
+    // overhangAmplitude blocks, and caves are carved wherever cave noise exceeds caveThreshold
+    // above caveMinY. Zero amplitude with caves off gives pure heightmap terrain.
+    float overhangAmplitude = 6.0f;
+    float overhangFrequency = 0.02f;
+    bool caves = true;
+    float caveFrequency = 0.02f;
+    float caveThreshold = 0.55f;
+    int caveMinY = 6;
+    // Older builds sampled a full FBm fractal for every octave (octaves^2 noise samples per
+    // column). Enable to reproduce those worlds exactly; the default samples each octave once,
+    // which is several times faster but shapes the same seed differently.
+    bool legacyNestedFractal = false;
 };
 
 struct LODSettings
@@ -30,6 +46,61 @@ struct StreamSettings
     int loadRadius = 10;
     int meshRadius = 9;
     int renderRadius = 8;
+    // Chunks within this Chebyshev distance of the camera, and edited chunks, are meshed as
+    // parallel per-orientation sub-jobs to cut edit-to-visible latency.
+    int urgentMeshRadius = 1;
+    // A chunk is meshed once its four neighbours are finalized, so its borders are built once
+    // against their real blocks; chunks at the edge of the load area go ahead after
+    // meshNeighborWaitSeconds. Remesh requests within meshCoalesceSeconds of the first are
+    // served by one job. Edits are never held back.
+    float meshCoalesceSeconds = 0.05f;
+    float meshNeighborWaitSeconds = 1.0f;
+    // The load and render areas are discs of these radii. Waiting chunks are generated in
+    // order of distance from the camera or from where it will be prefetchSeconds from now,
+    // whichever is nearer; chunks within viewHalfAngle degrees of the view direction (the
+    // horizontal frustum plus a margin for turning) count as viewBonus times as far.
+    float prefetchSeconds = 1.0f;
+    float viewHalfAngle = 75.0f;
+    float viewBonus = 0.5f;
+    // Finished meshes are uploaded to the GPU nearest and most visible first, until either
+    // budget for the frame is spent. At least one chunk goes up every frame, and meshes of
+    // edited chunks always do.
+    float uploadBudgetMs = 2.0f;
+    std::size_t uploadBudgetBytes = 8u << 20;
+    // Finished chunks leaving the unload radius are kept compressed (a few KiB each, against
+    // about 200 KiB loaded) and restored instead of regenerated if the camera comes back.
+    // Least recently unloaded chunks are dropped past this budget.
+    std::size_t warmCacheBytes = 64u << 20;
+    // Generated and edited chunks are saved to region files in this directory as they are
+    // unloaded and on exit, and chunks found there are loaded instead of generated. Regions
+    // written under another generator config are ignored. Empty disables persistence.
+    const char* worldDirectory = "world";
+};
+
+// Caps on what the streamer may hold, per category; 0 leaves a category unlimited. Past a
+// cap the streamer frees what it can rebuild: it shrinks GPU buffers with room to spare,
+// drops the CPU copies of meshes already on the GPU and evicts the LODs chunks are not drawn
+// at, farthest chunks first. Voxel data cannot be rebuilt cheaply, so past its cap a chunk
+// only loads in place of ones farther out, which go back to the warm cache. See
+// World/MemoryBudget.hpp.
+struct MemorySettings
+{
+    std::size_t voxelBytes = 512u << 20;
+    std::size_t cpuMeshBytes = 256u << 20;
+    std::size_t gpuVertexBytes = 512u << 20;
+    std::size_t gpuIndexBytes = 256u << 20;
+    // Finished meshes waiting for the GPU and the buffers pooled for mesh jobs.
+    std::size_t jobBytes = 128u << 20;
+};
+
+struct FarTerrainSettings
+{
+    bool enabled = true;
+    // Clipmap levels beyond the voxel chunks; each level doubles the sample spacing and the
+    // area covered. Level 0 always reaches at least 64 * baseSpacing blocks from the camera,
+    // which must clear the voxel render radius.
+    int levels = 5;
+    int baseSpacing = 4;
 };
 
 struct AtlasSettings
@@ -49,6 +120,8 @@ struct AppSettings
 NoiseSettings noise();
 LODSettings lod();
 StreamSettings streaming();
+MemorySettings memory();
+FarTerrainSettings far_terrain();
 AtlasSettings atlas();
 AppSettings app();
 
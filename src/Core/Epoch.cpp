@@ -0,0 +1,131 @@
+#include "Epoch.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace core
+{
+namespace
+{
+std::mutex g_indexMutex;
+std::vector<std::size_t> g_freeIndices;
+std::size_t g_nextIndex = 0;
+// One past the highest index handed out so far; collect() scans no further.
+std::atomic<std::size_t> g_indexLimit{0};
+
+// Index of the calling thread, reused once the thread exits.
+struct ThreadIndex
+{
+    ThreadIndex()
+    {
+        std::lock_guard lock(g_indexMutex);
+        if (!g_freeIndices.empty())
+        {
+            value = g_freeIndices.back();
+            g_freeIndices.pop_back();
+        }
+        else
+        {
+            value = g_nextIndex++;
+            g_indexLimit.store(g_nextIndex, std::memory_order_release);
+        }
+    }
+
+    ~ThreadIndex()
+    {
+        std::lock_guard lock(g_indexMutex);
+        g_freeIndices.push_back(value);
+    }
+
+    std::size_t value = 0;
+};
+
+std::size_t thread_index()
+{
+    thread_local ThreadIndex index;
+    return index.value;
+}
+} // namespace
+
+EpochDomain::EpochDomain() : m_slots(std::make_unique<ThreadSlot[]>(MaxThreads))
+{
+}
+
+EpochDomain::~EpochDomain()
+{
+    for (const Retired& retired : m_retired)
+    {
+        retired.deleter(retired.object);
+    }
+}
+
+// The fence pairs with the one in retire(): either this thread's later loads see the unlink
+// that preceded the retirement, or collect() sees this thread pinned at an epoch that is not
+// past the retirement and keeps the object.
+void EpochDomain::pin()
+{
+    const std::size_t index = thread_index();
+    assert(index < MaxThreads);
+    ThreadSlot& slot = m_slots[index];
+    if (slot.depth++ == 0)
+    {
+        slot.epoch.store(m_epoch.load(), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochDomain::unpin()
+{
+    ThreadSlot& slot = m_slots[thread_index()];
+    if (--slot.depth == 0)
+        slot.epoch.store(0, std::memory_order_release);
+}
+
+// An object retired at epoch e is only reachable for threads pinned at e or earlier, since
+// anyone reading the epoch after the increment also sees the unlink.
+void EpochDomain::retire(void* object, void (*deleter)(void*))
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint64_t epoch = m_epoch.fetch_add(1);
+    std::lock_guard lock(m_retiredMutex);
+    m_retired.push_back({object, deleter, epoch});
+}
+
+std::size_t EpochDomain::collect()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t oldest = m_epoch.load();
+    const std::size_t limit = std::min(g_indexLimit.load(std::memory_order_acquire), MaxThreads);
+    for (std::size_t index = 0; index < limit; ++index)
+    {
+        const std::uint64_t pinned = m_slots[index].epoch.load(std::memory_order_acquire);
+        if (pinned != 0)
+            oldest = std::min(oldest, pinned);
+    }
+
+    std::vector<Retired> ready;
+    {
+        std::lock_guard lock(m_retiredMutex);
+        const auto waiting = std::partition(m_retired.begin(), m_retired.end(), [oldest](const Retired& retired) {
+            return retired.epoch >= oldest;
+        });
+        ready.assign(waiting, m_retired.end());
+        m_retired.erase(waiting, m_retired.end());
+    }
+    // Deleters run outside the lock: they may retire further objects.
+    for (const Retired& retired : ready)
+    {
+        retired.deleter(retired.object);
+    }
+
+    std::lock_guard lock(m_retiredMutex);
+    return m_retired.size();
+}
+
+std::size_t EpochDomain::retired() const
+{
+    std::lock_guard lock(m_retiredMutex);
+    return m_retired.size();
+}
+
+} // namespace core
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core
+{
+// Epoch-based reclamation. Threads pin the domain (EpochGuard) while they use objects that
+// another thread may unlink at any moment; an unlinked object is retired instead of deleted
+// and collect() frees it once every thread that was pinned when it was retired has let go.
+// Pinning writes only a cache line owned by the pinning thread, so readers never contend the
+// way they do on a shared reference count.
+//
+// Guards nest and may be taken on any thread. Objects are freed on the thread calling
+// collect(), or by the destructor, which must run once no thread is pinned any more.
+class EpochDomain
+{
+  public:
+    EpochDomain();
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // The object must already be unreachable for threads that pin from now on.
+    template <typename T> void retire(T* object)
+    {
+        retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+    }
+    void retire(void* object, void (*deleter)(void*));
+
+    // Frees the retired objects no pinned thread can still hold and returns how many remain.
+    std::size_t collect();
+    std::size_t retired() const;
+
+  private:
+    friend class EpochGuard;
+
+    // Threads are told apart by a small process-wide index; see thread_index().
+    static constexpr std::size_t MaxThreads = 1024;
+
+    struct alignas(64) ThreadSlot
+    {
+        // Epoch the thread pinned at, or 0 while it is not pinned.
+        std::atomic<std::uint64_t> epoch{0};
+        // Guards currently held by the owning thread; only it touches this.
+        int depth = 0;
+    };
+
+    struct Retired
+    {
+        void* object;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    void pin();
+    void unpin();
+
+    std::atomic<std::uint64_t> m_epoch{1};
+    std::unique_ptr<ThreadSlot[]> m_slots;
+
+    mutable std::mutex m_retiredMutex;
+    std::vector<Retired> m_retired;
+};
+
+class EpochGuard
+{
+  public:
+    explicit EpochGuard(EpochDomain& domain) : m_domain(domain) { m_domain.pin(); }
+    ~EpochGuard() { m_domain.unpin(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+  private:
+    EpochDomain& m_domain;
+};
+
+} // namespace core
@@ -34,7 +34,16 @@ void JobSystem::enqueue(Job job)
 {
     {
         std::lock_guard lock(m_mutex);
-        m_jobs.push(std::move(job));
+        m_jobs.push_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+void JobSystem::enqueue_urgent(Job job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_jobs.push_front(std::move(job));
     }
     m_cv.notify_one();
 }
@@ -58,7 +67,7 @@ void JobSystem::worker_loop()
                 return;
             }
             job = std::move(m_jobs.front());
-            m_jobs.pop();
+            m_jobs.pop_front();
         }
 
         if (job)
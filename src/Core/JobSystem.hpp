@@ -5,7 +5,7 @@
 #include <cstdint>
 #include <functional>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <thread>
 #include <vector>
 
@@ -23,6 +23,8 @@ class JobSystem
     JobSystem& operator=(const JobSystem&) = delete;
 
     void enqueue(Job job);
+    // Places the job ahead of everything already queued; used for latency-critical work.
+    void enqueue_urgent(Job job);
     std::size_t pending_jobs() const;
 
   private:
@@ -30,7 +32,7 @@ class JobSystem
 
     mutable std::mutex m_mutex;
     std::condition_variable m_cv;
-    std::queue<Job> m_jobs;
+    std::deque<Job> m_jobs;
     std::vector<std::thread> m_workers;
     std::atomic<bool> m_running{true};
 };
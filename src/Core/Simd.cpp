@@ -0,0 +1,488 @@
+#include "Simd.hpp"
+
+#include "Util/Logging.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CODEX_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define CODEX_SIMD_X86 0
+#endif
+
+// Each variant is compiled for its own instruction set through a function-level target so the
+// project can keep building for the baseline architecture. MSVC exposes every intrinsic
+// without per-function targets.
+#if CODEX_SIMD_X86 && !defined(_MSC_VER)
+#define CODEX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CODEX_TARGET(isa)
+#endif
+
+namespace core::simd
+{
+namespace
+{
+struct Kernels
+{
+    Isa isa = Isa::Scalar;
+    bool (*allEqual)(const std::uint16_t*, std::size_t, std::uint16_t) = nullptr;
+    std::size_t (*runLength)(const std::uint16_t*, std::size_t, std::uint16_t) = nullptr;
+    void (*equalMask)(const std::uint16_t*, std::size_t, std::uint16_t, std::uint64_t*) = nullptr;
+    void (*fill)(std::uint16_t*, std::size_t, std::uint16_t) = nullptr;
+    void (*copy)(std::uint16_t*, const std::uint16_t*, std::size_t) = nullptr;
+};
+
+// ---------------------------------------------------------------------------------------------
+// Scalar fallback. Also used for the tails the vector variants leave behind.
+
+bool all_equal_scalar(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (data[i] != value)
+            return false;
+    }
+    return true;
+}
+
+std::size_t run_length_scalar(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    std::size_t i = 0;
+    while (i < count && data[i] == value)
+    {
+        ++i;
+    }
+    return i;
+}
+
+void equal_mask_tail(const std::uint16_t* data, std::size_t begin, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    for (std::size_t i = begin; i < count; ++i)
+    {
+        if (data[i] == value)
+        {
+            mask[i / 64] |= std::uint64_t{1} << (i % 64);
+        }
+    }
+}
+
+void clear_mask(std::size_t count, std::uint64_t* mask)
+{
+    std::fill(mask, mask + (count + 63) / 64, std::uint64_t{0});
+}
+
+void equal_mask_scalar(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    clear_mask(count, mask);
+    equal_mask_tail(data, 0, count, value, mask);
+}
+
+void fill_scalar(std::uint16_t* dst, std::size_t count, std::uint16_t value)
+{
+    std::fill(dst, dst + count, value);
+}
+
+void copy_scalar(std::uint16_t* dst, const std::uint16_t* src, std::size_t count)
+{
+    if (count)
+    {
+        std::memcpy(dst, src, count * sizeof(std::uint16_t));
+    }
+}
+
+#if CODEX_SIMD_X86
+// ---------------------------------------------------------------------------------------------
+// SSE4.2 (128-bit, 8 lanes)
+
+CODEX_TARGET("sse4.2")
+bool all_equal_sse42(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m128i target = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, target)) != 0xFFFF)
+            return false;
+    }
+    return all_equal_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("sse4.2")
+std::size_t run_length_sse42(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m128i target = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, target)));
+        if (equal != 0xFFFFu)
+            return i + static_cast<std::size_t>(std::countr_zero(~equal)) / 2;
+    }
+    return i + run_length_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("sse4.2")
+void equal_mask_sse42(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    clear_mask(count, mask);
+    const __m128i target = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), target);
+        const __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 8)), target);
+        const auto bits = static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(a, b))));
+        mask[i / 64] |= bits << (i % 64);
+    }
+    equal_mask_tail(data, i, count, value, mask);
+}
+
+CODEX_TARGET("sse4.2")
+void fill_sse42(std::uint16_t* dst, std::size_t count, std::uint16_t value)
+{
+    const __m128i v = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+    fill_scalar(dst + i, count - i, value);
+}
+
+CODEX_TARGET("sse4.2")
+void copy_sse42(std::uint16_t* dst, const std::uint16_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    }
+    copy_scalar(dst + i, src + i, count - i);
+}
+
+// ---------------------------------------------------------------------------------------------
+// AVX2 (256-bit, 16 lanes)
+
+CODEX_TARGET("avx2")
+bool all_equal_avx2(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m256i target = _mm256_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, target)) != -1)
+            return false;
+    }
+    return all_equal_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("avx2")
+std::size_t run_length_avx2(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m256i target = _mm256_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const auto equal = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, target)));
+        if (equal != 0xFFFFFFFFu)
+            return i + static_cast<std::size_t>(std::countr_zero(~equal)) / 2;
+    }
+    return i + run_length_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("avx2")
+void equal_mask_avx2(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    clear_mask(count, mask);
+    const __m256i target = _mm256_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), target);
+        const __m256i b = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 16)), target);
+        // packs interleaves 128-bit lanes; restore element order before taking the byte mask.
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        const auto bits = static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(packed)));
+        mask[i / 64] |= bits << (i % 64);
+    }
+    equal_mask_tail(data, i, count, value, mask);
+}
+
+CODEX_TARGET("avx2")
+void fill_avx2(std::uint16_t* dst, std::size_t count, std::uint16_t value)
+{
+    const __m256i v = _mm256_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    fill_scalar(dst + i, count - i, value);
+}
+
+CODEX_TARGET("avx2")
+void copy_avx2(std::uint16_t* dst, const std::uint16_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    copy_scalar(dst + i, src + i, count - i);
+}
+
+// ---------------------------------------------------------------------------------------------
+// AVX-512 (F + BW, 512-bit, 32 lanes)
+
+CODEX_TARGET("avx512f,avx512bw")
+bool all_equal_avx512(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m512i target = _mm512_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        if (_mm512_cmpneq_epi16_mask(_mm512_loadu_si512(data + i), target) != 0)
+            return false;
+    }
+    return all_equal_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("avx512f,avx512bw")
+std::size_t run_length_avx512(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    const __m512i target = _mm512_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const auto differ = static_cast<std::uint32_t>(_mm512_cmpneq_epi16_mask(_mm512_loadu_si512(data + i), target));
+        if (differ != 0)
+            return i + static_cast<std::size_t>(std::countr_zero(differ));
+    }
+    return i + run_length_scalar(data + i, count - i, value);
+}
+
+CODEX_TARGET("avx512f,avx512bw")
+void equal_mask_avx512(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    clear_mask(count, mask);
+    const __m512i target = _mm512_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const auto bits = static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm512_cmpeq_epi16_mask(_mm512_loadu_si512(data + i), target)));
+        mask[i / 64] |= bits << (i % 64);
+    }
+    equal_mask_tail(data, i, count, value, mask);
+}
+
+CODEX_TARGET("avx512f,avx512bw")
+void fill_avx512(std::uint16_t* dst, std::size_t count, std::uint16_t value)
+{
+    const __m512i v = _mm512_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        _mm512_storeu_si512(dst + i, v);
+    }
+    fill_scalar(dst + i, count - i, value);
+}
+
+CODEX_TARGET("avx512f,avx512bw")
+void copy_avx512(std::uint16_t* dst, const std::uint16_t* src, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+    }
+    copy_scalar(dst + i, src + i, count - i);
+}
+
+// ---------------------------------------------------------------------------------------------
+// CPU feature detection
+
+void cpuid(unsigned leaf, unsigned subleaf, unsigned (&regs)[4])
+{
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i)
+    {
+        regs[i] = static_cast<unsigned>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+std::uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax = 0;
+    unsigned edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+Isa detect_isa()
+{
+    unsigned regs[4] = {};
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return Isa::Scalar;
+
+    cpuid(1, 0, regs);
+    const bool sse42 = (regs[2] & (1u << 20)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    if (!sse42)
+        return Isa::Scalar;
+
+    // The wider register files are only usable once the OS saves them on context switch.
+    const std::uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, regs);
+        avx2 = (regs[1] & (1u << 5)) != 0;
+        const bool avx512f = (regs[1] & (1u << 16)) != 0;
+        const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+        avx512 = avx512f && avx512bw;
+    }
+
+    if (avx && avx512 && zmmEnabled)
+        return Isa::Avx512;
+    if (avx && avx2 && ymmEnabled)
+        return Isa::Avx2;
+    return Isa::Sse42;
+}
+#else
+Isa detect_isa()
+{
+    return Isa::Scalar;
+}
+#endif
+
+Isa requested_cap()
+{
+    const char* env = std::getenv("CODEXCRAFT_SIMD");
+    if (!env)
+        return Isa::Avx512;
+
+    const std::string_view value(env);
+    if (value == "scalar")
+        return Isa::Scalar;
+    if (value == "sse42")
+        return Isa::Sse42;
+    if (value == "avx2")
+        return Isa::Avx2;
+    return Isa::Avx512;
+}
+
+Kernels select_kernels()
+{
+    Kernels k;
+    k.allEqual = all_equal_scalar;
+    k.runLength = run_length_scalar;
+    k.equalMask = equal_mask_scalar;
+    k.fill = fill_scalar;
+    k.copy = copy_scalar;
+
+    const Isa isa = std::min(detect_isa(), requested_cap());
+#if CODEX_SIMD_X86
+    switch (isa)
+    {
+    case Isa::Avx512:
+        k = {Isa::Avx512, all_equal_avx512, run_length_avx512, equal_mask_avx512, fill_avx512, copy_avx512};
+        break;
+    case Isa::Avx2:
+        k = {Isa::Avx2, all_equal_avx2, run_length_avx2, equal_mask_avx2, fill_avx2, copy_avx2};
+        break;
+    case Isa::Sse42:
+        k = {Isa::Sse42, all_equal_sse42, run_length_sse42, equal_mask_sse42, fill_sse42, copy_sse42};
+        break;
+    case Isa::Scalar:
+        break;
+    }
+#else
+    (void)isa;
+#endif
+
+    util::log().info("SIMD kernels: %s", isa_name(k.isa));
+    return k;
+}
+
+const Kernels& kernels()
+{
+    static const Kernels g_kernels = select_kernels();
+    return g_kernels;
+}
+
+} // namespace
+
+Isa active_isa()
+{
+    return kernels().isa;
+}
+
+const char* isa_name(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar: return "scalar";
+    case Isa::Sse42: return "sse4.2";
+    case Isa::Avx2: return "avx2";
+    case Isa::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool all_equal_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    return kernels().allEqual(data, count, value);
+}
+
+std::size_t run_length_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value)
+{
+    return kernels().runLength(data, count, value);
+}
+
+void equal_mask_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask)
+{
+    kernels().equalMask(data, count, value, mask);
+}
+
+void fill_u16(std::uint16_t* dst, std::size_t count, std::uint16_t value)
+{
+    kernels().fill(dst, count, value);
+}
+
+void copy_u16(std::uint16_t* dst, const std::uint16_t* src, std::size_t count)
+{
+    kernels().copy(dst, src, count);
+}
+
+} // namespace core::simd
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace core::simd
+{
+enum class Isa : std::uint8_t
+{
+    Scalar,
+    Sse42,
+    Avx2,
+    Avx512
+};
+
+// Kernels are selected once, on first use, from CPUID (and the OS-enabled register state), so a
+// single binary runs the widest variant each host supports. Setting CODEXCRAFT_SIMD to scalar,
+// sse42, avx2 or avx512 caps the selection, which is handy for checking fallbacks.
+Isa active_isa();
+const char* isa_name(Isa isa);
+
+// True if every element of data[0, count) equals value. An empty range is uniform.
+bool all_equal_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value);
+
+// Length of the leading run of elements equal to value.
+std::size_t run_length_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value);
+
+// Sets bit i of mask when data[i] == value. mask must hold (count + 63) / 64 words; bits past
+// count are cleared.
+void equal_mask_u16(const std::uint16_t* data, std::size_t count, std::uint16_t value, std::uint64_t* mask);
+
+void fill_u16(std::uint16_t* dst, std::size_t count, std::uint16_t value);
+void copy_u16(std::uint16_t* dst, const std::uint16_t* src, std::size_t count);
+
+} // namespace core::simd
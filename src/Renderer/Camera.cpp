@@ -20,6 +20,11 @@ void Camera::set_perspective(float fovRadians, float aspect, float nearPlane, fl
     m_projection = util::perspective(fovRadians, aspect, nearPlane, farPlane);
 }
 
+glm::mat4 Camera::projection(float nearPlane, float farPlane) const
+{
+    return util::perspective(m_fov, m_aspect, nearPlane, farPlane);
+}
+
 void Camera::resize(int width, int height)
 {
     m_aspect = static_cast<float>(width) / static_cast<float>(height);
@@ -19,6 +19,8 @@ class Camera
 
     glm::mat4 view() const;
     glm::mat4 projection() const { return m_projection; }
+    // Same field of view and aspect with a different depth range, e.g. for distant terrain.
+    glm::mat4 projection(float nearPlane, float farPlane) const;
     glm::vec3 position() const { return m_position; }
     glm::vec3 forward() const;
 
@@ -13,9 +13,6 @@ namespace renderer
 class GLContext
 {
   public:
-    GLContext() = default;
-    explicit GLContext(WindowPtr window) : m_window(std::move(window)) {}
-
     struct Deleter
     {
         void operator()(GLFWwindow* window) const noexcept;
@@ -23,6 +20,9 @@ class GLContext
 
     using WindowPtr = std::unique_ptr<GLFWwindow, Deleter>;
 
+    GLContext() = default;
+    explicit GLContext(WindowPtr window) : m_window(std::move(window)) {}
+
     static GLContext create(int width, int height, bool fullscreen, const std::string& title);
 
     GLFWwindow* window() const { return m_window.get(); }
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace renderer
+{
+struct ChunkVertex
+{
+    float position[3];
+    std::uint32_t normalPacked;
+    float uv[2];
+    std::uint8_t light;
+    std::uint8_t layer; // Block texture array layer.
+    std::uint8_t padding[2]{}; // Align to 4 bytes for std140 friendly layout.
+};
+
+// Packs a unit normal into 10 bits per axis, as decoded by the chunk vertex shader.
+inline std::uint32_t pack_normal(const glm::vec3& n)
+{
+    const auto encode = [](float value) {
+        const float scaled = std::clamp((value * 0.5f + 0.5f) * 1023.0f, 0.0f, 1023.0f);
+        return static_cast<std::uint32_t>(scaled);
+    };
+    const std::uint32_t x = encode(n.x);
+    const std::uint32_t y = encode(n.y);
+    const std::uint32_t z = encode(n.z);
+    return (x & 0x3FFu) | ((y & 0x3FFu) << 10) | ((z & 0x3FFu) << 20);
+}
+
+// The GPU copy of a mesh, as seen by code that builds meshes. The world code (streamer, far
+// terrain) only holds these through a MeshFactory, so it builds and runs without a graphics
+// API; Mesh is the OpenGL implementation. Main (render) thread only.
+class GpuMesh
+{
+  public:
+    virtual ~GpuMesh() = default;
+
+    // One run of a mesh's vertices and indices; the indices are relative to its first vertex.
+    struct Part
+    {
+        std::span<const ChunkVertex> vertices;
+        std::span<const std::uint32_t> indices;
+    };
+
+    // Uploads a mesh made of parts laid out back to back and drawn with one call. Parts before
+    // firstChanged must be the ones sent last time: they keep their place on the GPU and are
+    // not sent again, unless the part count changed or a buffer has to grow. Returns the
+    // number of bytes sent.
+    virtual std::size_t upload_parts(std::span<const Part> parts, std::size_t firstChanged = 0, bool dynamic = false) = 0;
+    virtual void draw() const = 0;
+    virtual bool empty() const = 0;
+
+    // GPU memory allocated for vertices and indices, which may exceed what is drawn.
+    virtual std::size_t vertex_bytes() const = 0;
+    virtual std::size_t index_bytes() const = 0;
+    // Reallocates buffers with room to spare down to what is drawn, keeping their contents.
+    // Returns the number of bytes freed.
+    virtual std::size_t shrink_to_fit() = 0;
+
+    std::size_t upload(const std::vector<ChunkVertex>& vertices, const std::vector<std::uint32_t>& indices, bool dynamic = false)
+    {
+        const Part part{vertices, indices};
+        return upload_parts(std::span<const Part>(&part, 1), 0, dynamic);
+    }
+};
+
+// Creates GpuMeshes for the world code. Creating one must not need the graphics context;
+// implementations allocate GPU objects on the first upload.
+class MeshFactory
+{
+  public:
+    virtual ~MeshFactory() = default;
+    virtual std::unique_ptr<GpuMesh> create_mesh() = 0;
+};
+
+} // namespace renderer
@@ -1,12 +1,13 @@
 #include "Mesh.hpp"
 
+#include <algorithm>
 #include <cstddef>
 
 #include <glad/glad.h>
 
 namespace renderer
 {
-Mesh::Mesh()
+void Mesh::create()
 {
     glCreateVertexArrays(1, &m_vao);
     glCreateBuffers(1, &m_vbo);
@@ -29,6 +30,10 @@ Mesh::Mesh()
     glVertexArrayAttribIFormat(m_vao, 3, 1, GL_UNSIGNED_BYTE, offsetof(ChunkVertex, light));
     glVertexArrayAttribBinding(m_vao, 3, 0);
 
+    glEnableVertexArrayAttrib(m_vao, 4);
+    glVertexArrayAttribIFormat(m_vao, 4, 1, GL_UNSIGNED_BYTE, offsetof(ChunkVertex, layer));
+    glVertexArrayAttribBinding(m_vao, 4, 0);
+
     glVertexArrayElementBuffer(m_vao, m_ibo);
 }
 
@@ -54,6 +59,10 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
         std::swap(m_indexCapacity, other.m_indexCapacity);
         std::swap(m_indexCount, other.m_indexCount);
         std::swap(m_dynamic, other.m_dynamic);
+        std::swap(m_parts, other.m_parts);
+        std::swap(m_drawCounts, other.m_drawCounts);
+        std::swap(m_drawOffsets, other.m_drawOffsets);
+        std::swap(m_drawBaseVertices, other.m_drawBaseVertices);
     }
     return *this;
 }
@@ -69,33 +78,116 @@ void Mesh::destroy()
     }
 }
 
-void Mesh::upload(const std::vector<ChunkVertex>& vertices, const std::vector<std::uint32_t>& indices, bool dynamic)
+std::size_t Mesh::upload_parts(std::span<const Part> parts, std::size_t firstChanged, bool dynamic)
 {
-    m_dynamic = dynamic;
-    const auto vertexCount = vertices.size();
-    const auto indexCount = indices.size();
+    if (!m_vao)
+        create();
+
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    for (const Part& part : parts)
+    {
+        vertexCount += part.vertices.size();
+        indexCount += part.indices.size();
+    }
+
+    firstChanged = parts.size() == m_parts.size() ? std::min(firstChanged, parts.size()) : 0;
 
+    // A buffer that has to grow is reallocated, which loses the parts kept in place.
+    const GLenum usage = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
     if (vertexCount > m_vertexCapacity)
     {
-        glNamedBufferData(m_vbo, static_cast<GLsizeiptr>(vertexCount * sizeof(ChunkVertex)), vertices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        glNamedBufferData(m_vbo, static_cast<GLsizeiptr>(vertexCount * sizeof(ChunkVertex)), nullptr, usage);
         m_vertexCapacity = vertexCount;
+        firstChanged = 0;
     }
-    else
+    if (indexCount > m_indexCapacity)
     {
-        glNamedBufferSubData(m_vbo, 0, static_cast<GLsizeiptr>(vertexCount * sizeof(ChunkVertex)), vertices.data());
+        glNamedBufferData(m_ibo, static_cast<GLsizeiptr>(indexCount * sizeof(std::uint32_t)), nullptr, usage);
+        m_indexCapacity = indexCount;
+        firstChanged = 0;
     }
+    m_dynamic = dynamic;
 
-    if (indexCount > m_indexCapacity)
+    m_parts.resize(parts.size());
+    std::size_t vertexOffset = 0;
+    std::size_t indexOffset = 0;
+    std::size_t sent = 0;
+    if (firstChanged > 0)
     {
-        glNamedBufferData(m_ibo, static_cast<GLsizeiptr>(indexCount * sizeof(std::uint32_t)), indices.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-        m_indexCapacity = indexCount;
+        const PartRange& kept = m_parts[firstChanged - 1];
+        vertexOffset = kept.firstVertex + kept.vertexCount;
+        indexOffset = kept.firstIndex + kept.indexCount;
     }
-    else
+    for (std::size_t index = firstChanged; index < parts.size(); ++index)
     {
-        glNamedBufferSubData(m_ibo, 0, static_cast<GLsizeiptr>(indexCount * sizeof(std::uint32_t)), indices.data());
+        const Part& part = parts[index];
+        if (!part.vertices.empty())
+            glNamedBufferSubData(m_vbo, static_cast<GLintptr>(vertexOffset * sizeof(ChunkVertex)), static_cast<GLsizeiptr>(part.vertices.size_bytes()), part.vertices.data());
+        if (!part.indices.empty())
+            glNamedBufferSubData(m_ibo, static_cast<GLintptr>(indexOffset * sizeof(std::uint32_t)), static_cast<GLsizeiptr>(part.indices.size_bytes()), part.indices.data());
+        m_parts[index] = {vertexOffset, indexOffset, part.vertices.size(), part.indices.size()};
+        sent += part.vertices.size_bytes() + part.indices.size_bytes();
+        vertexOffset += part.vertices.size();
+        indexOffset += part.indices.size();
     }
 
+    m_drawCounts.clear();
+    m_drawOffsets.clear();
+    m_drawBaseVertices.clear();
+    for (const PartRange& range : m_parts)
+    {
+        if (range.indexCount == 0)
+            continue;
+        m_drawCounts.push_back(static_cast<int>(range.indexCount));
+        m_drawOffsets.push_back(reinterpret_cast<const void*>(range.firstIndex * sizeof(std::uint32_t)));
+        m_drawBaseVertices.push_back(static_cast<int>(range.firstVertex));
+    }
     m_indexCount = static_cast<std::uint32_t>(indexCount);
+    return sent;
+}
+
+void Mesh::reallocate(unsigned& buffer, std::size_t bytes)
+{
+    unsigned replacement = 0;
+    glCreateBuffers(1, &replacement);
+    glNamedBufferData(replacement, static_cast<GLsizeiptr>(bytes), nullptr, m_dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    if (bytes > 0)
+        glCopyNamedBufferSubData(buffer, replacement, 0, 0, static_cast<GLsizeiptr>(bytes));
+    glDeleteBuffers(1, &buffer);
+    buffer = replacement;
+}
+
+// The copy stays on the GPU, so a mesh whose CPU copy is gone can still be shrunk.
+std::size_t Mesh::shrink_to_fit()
+{
+    if (!m_vao)
+        return 0;
+
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    for (const PartRange& range : m_parts)
+    {
+        vertexCount += range.vertexCount;
+        indexCount += range.indexCount;
+    }
+
+    std::size_t freed = 0;
+    if (vertexCount < m_vertexCapacity)
+    {
+        reallocate(m_vbo, vertexCount * sizeof(ChunkVertex));
+        glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(ChunkVertex));
+        freed += (m_vertexCapacity - vertexCount) * sizeof(ChunkVertex);
+        m_vertexCapacity = vertexCount;
+    }
+    if (indexCount < m_indexCapacity)
+    {
+        reallocate(m_ibo, indexCount * sizeof(std::uint32_t));
+        glVertexArrayElementBuffer(m_vao, m_ibo);
+        freed += (m_indexCapacity - indexCount) * sizeof(std::uint32_t);
+        m_indexCapacity = indexCount;
+    }
+    return freed;
 }
 
 void Mesh::draw() const
@@ -104,7 +196,12 @@ void Mesh::draw() const
         return;
 
     glBindVertexArray(m_vao);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, nullptr);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES,
+                                  m_drawCounts.data(),
+                                  GL_UNSIGNED_INT,
+                                  m_drawOffsets.data(),
+                                  static_cast<GLsizei>(m_drawCounts.size()),
+                                  m_drawBaseVertices.data());
 }
 
 } // namespace renderer
@@ -1,37 +1,49 @@
 #pragma once
 
+#include "GpuMesh.hpp"
+
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 namespace renderer
 {
-struct ChunkVertex
-{
-    float position[3];
-    std::uint32_t normalPacked;
-    float uv[2];
-    std::uint8_t light;
-    std::uint8_t padding[3]{}; // Align to 4 bytes for std140 friendly layout.
-};
-
-class Mesh
+// OpenGL mesh. The vertex array and buffers are created by the first upload, so a mesh that
+// is never uploaded costs no GL objects and can be created without a context. The parts are
+// drawn with one multi-draw call.
+class Mesh final : public GpuMesh
 {
   public:
-    Mesh();
-    ~Mesh();
+    Mesh() = default;
+    ~Mesh() override;
 
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
     Mesh(Mesh&& other) noexcept;
     Mesh& operator=(Mesh&& other) noexcept;
 
-    void upload(const std::vector<ChunkVertex>& vertices, const std::vector<std::uint32_t>& indices, bool dynamic = false);
-    void draw() const;
-    bool empty() const { return m_indexCount == 0; }
+    std::size_t upload_parts(std::span<const Part> parts, std::size_t firstChanged = 0, bool dynamic = false) override;
+    void draw() const override;
+    bool empty() const override { return m_indexCount == 0; }
+
+    std::size_t vertex_bytes() const override { return m_vertexCapacity * sizeof(ChunkVertex); }
+    std::size_t index_bytes() const override { return m_indexCapacity * sizeof(std::uint32_t); }
+    std::size_t shrink_to_fit() override;
 
   private:
+    struct PartRange
+    {
+        std::size_t firstVertex = 0;
+        std::size_t firstIndex = 0;
+        std::size_t vertexCount = 0;
+        std::size_t indexCount = 0;
+    };
+
+    void create();
     void destroy();
+    // Replaces buffer with one of `bytes` holding its first `bytes`.
+    void reallocate(unsigned& buffer, std::size_t bytes);
 
     unsigned m_vao = 0;
     unsigned m_vbo = 0;
@@ -40,6 +52,17 @@ class Mesh
     std::size_t m_indexCapacity = 0;
     std::uint32_t m_indexCount = 0;
     bool m_dynamic = false;
+    std::vector<PartRange> m_parts;
+    // Arguments of the multi-draw call, one entry per non-empty part.
+    std::vector<int> m_drawCounts;
+    std::vector<const void*> m_drawOffsets;
+    std::vector<int> m_drawBaseVertices;
+};
+
+class GLMeshFactory final : public MeshFactory
+{
+  public:
+    std::unique_ptr<GpuMesh> create_mesh() override { return std::make_unique<Mesh>(); }
 };
 
 } // namespace renderer
@@ -2,6 +2,8 @@
 
 #include "Util/Logging.hpp"
 
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,10 +12,16 @@
 namespace renderer
 {
 Texture::~Texture()
+{
+    destroy();
+}
+
+void Texture::destroy()
 {
     if (m_handle)
     {
         glDeleteTextures(1, &m_handle);
+        m_handle = 0;
     }
 }
 
@@ -29,6 +37,7 @@ Texture& Texture::operator=(Texture&& other) noexcept
         std::swap(m_handle, other.m_handle);
         std::swap(m_width, other.m_width);
         std::swap(m_height, other.m_height);
+        std::swap(m_layers, other.m_layers);
     }
     return *this;
 }
@@ -66,6 +75,67 @@ bool Texture::load_atlas(const std::string& path, int expectedTilesX, int expect
     return true;
 }
 
+bool Texture::load_array(const std::string& path, int tilesX, int tilesY)
+{
+    stbi_set_flip_vertically_on_load(false);
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int channels = 0;
+    unsigned char* data = stbi_load(path.c_str(), &imageWidth, &imageHeight, &channels, STBI_rgb_alpha);
+    if (!data)
+    {
+        util::log().error("Failed to load atlas %s", path.c_str());
+        return false;
+    }
+
+    if ((imageWidth % tilesX) != 0 || (imageHeight % tilesY) != 0)
+    {
+        util::log().warn("Atlas size %dx%d does not align with %dx%d grid", imageWidth, imageHeight, tilesX, tilesY);
+    }
+
+    m_width = imageWidth / tilesX;
+    m_height = imageHeight / tilesY;
+    m_layers = tilesX * tilesY;
+
+    int levels = 1;
+    while ((std::max(m_width, m_height) >> levels) > 0)
+    {
+        ++levels;
+    }
+
+    // Immutable storage cannot be respecified, so a reload starts from a fresh texture.
+    destroy();
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_handle);
+    glTextureParameteri(m_handle, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(m_handle, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTextureParameteri(m_handle, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTextureParameteri(m_handle, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureStorage3D(m_handle, levels, GL_RGBA8, m_width, m_height, m_layers);
+
+    // Each tile is read straight out of the atlas image through the unpack skip state.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, imageWidth);
+    for (int tileY = 0; tileY < tilesY; ++tileY)
+    {
+        for (int tileX = 0; tileX < tilesX; ++tileX)
+        {
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, tileX * m_width);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, tileY * m_height);
+            glTextureSubImage3D(m_handle, 0, 0, 0, tileY * tilesX + tileX, m_width, m_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+    }
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Mipmaps of an array texture are generated per layer, so tiles never bleed into each other.
+    glGenerateTextureMipmap(m_handle);
+
+    stbi_image_free(data);
+    return true;
+}
+
 void Texture::bind(unsigned slot) const
 {
     glBindTextureUnit(slot, m_handle);
@@ -16,15 +16,23 @@ class Texture
     Texture& operator=(Texture&& other) noexcept;
 
     bool load_atlas(const std::string& path, int expectedTilesX, int expectedTilesY);
+    // Splits an atlas image into a GL_TEXTURE_2D_ARRAY with one layer per tile (row-major,
+    // layer = tileY * tilesX + tileX) and a full mip chain per layer. Wrapping repeats, so
+    // texture coordinates may run past 1 to tile a texture across a merged quad.
+    bool load_array(const std::string& path, int tilesX, int tilesY);
     void bind(unsigned slot = 0) const;
 
     int width() const { return m_width; }
     int height() const { return m_height; }
+    int layers() const { return m_layers; }
 
   private:
+    void destroy();
+
     unsigned m_handle = 0;
     int m_width = 0;
     int m_height = 0;
+    int m_layers = 1;
 };
 
 } // namespace renderer
@@ -0,0 +1,322 @@
+// CodexCraftPregen: generates a square area of chunks ahead of time so
+// servers and first visits do not pay for generation while a player waits.
+//
+// The area is cut into tiles that workers process independently. A tile runs the same stages
+// as WorldStreamer over its chunks plus a margin: terrain and decoration two chunks out (the
+// features of those chunks can reach one chunk in), finalize and light one chunk out (light
+// travels at most 15 blocks sideways, so the inner chunks get exactly the light they would get
+// in a fully loaded world), then encode.
+//
+// Output goes to region files (see World/RegionStore.hpp) in a world directory, so the game
+// loads the chunks instead of generating them when pointed at the same directory. Each chunk
+// is stored as a ChunkCodec record with its light; the game builds meshes itself once a
+// chunk's neighbours are loaded. A rerun skips every chunk already stored, so it simply
+// resumes; a record cut short by an interruption fails its checksum and is generated again.
+
+#include "World/ChunkCodec.hpp"
+#include "World/Decorator.hpp"
+#include "World/LightEngine.hpp"
+#include "World/RegionStore.hpp"
+#include "World/WorldGen.hpp"
+
+#include "Util/Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+using world::ChunkCoord;
+
+struct Options
+{
+    std::string output = "world";
+    ChunkCoord center{};
+    int size = 32;
+    int tile = 8;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+    world::WorldGenConfig config;
+};
+
+void print_usage()
+{
+    std::puts("Usage: CodexCraftPregen [options]\n"
+              "  --out <dir>            world directory (default world, as the game); rerun to resume\n"
+              "  --size <n>             pregenerate n x n chunks (default 32)\n"
+              "  --center <x> <z>       chunk at the centre of the area (default 0 0)\n"
+              "  --threads <n>          worker threads (default: all cores)\n"
+              "  --tile <n>             chunks per tile side handed to a worker (default 8)\n"
+              "  --seed <n> --frequency <f> --amplitude <f> --octaves <n> --base-height <f>\n"
+              "  --sea-level <f> --overhang <f> --no-caves --legacy-fractal\n"
+              "                         WorldGenConfig overrides");
+}
+
+bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--help")
+            return false;
+
+        const auto next = [&](auto& value) {
+            if (i + 1 >= argc)
+                return false;
+            const std::string text = argv[++i];
+            try
+            {
+                if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string>)
+                    value = text;
+                else if constexpr (std::is_floating_point_v<std::decay_t<decltype(value)>>)
+                    value = std::stof(text);
+                else
+                    value = static_cast<std::decay_t<decltype(value)>>(std::stol(text));
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+            return true;
+        };
+
+        bool ok = true;
+        if (arg == "--out")
+            ok = next(options.output);
+        else if (arg == "--size")
+            ok = next(options.size) && options.size > 0;
+        else if (arg == "--center")
+            ok = next(options.center.x) && next(options.center.z);
+        else if (arg == "--threads")
+            ok = next(options.threads) && options.threads > 0;
+        else if (arg == "--tile")
+            ok = next(options.tile) && options.tile > 0;
+        else if (arg == "--seed")
+            ok = next(options.config.seed);
+        else if (arg == "--frequency")
+            ok = next(options.config.frequency);
+        else if (arg == "--amplitude")
+            ok = next(options.config.amplitude);
+        else if (arg == "--octaves")
+            ok = next(options.config.octaves);
+        else if (arg == "--base-height")
+            ok = next(options.config.baseHeight);
+        else if (arg == "--sea-level")
+            ok = next(options.config.seaLevel);
+        else if (arg == "--overhang")
+            ok = next(options.config.overhangAmplitude);
+        else if (arg == "--no-caves")
+            options.config.caves = false;
+        else if (arg == "--legacy-fractal")
+            options.config.legacyNestedFractal = true;
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            util::log().error("Bad or unknown argument: %s", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Tile
+{
+    ChunkCoord min; // inclusive
+    ChunkCoord max; // exclusive
+};
+
+struct TileChunk
+{
+    world::ChunkPtr chunk;
+    std::vector<world::BlockWrite> decorations;
+};
+
+// Runs every stage for one tile and queues its records; chunks already stored are skipped.
+std::size_t process_tile(const Tile& tile,
+                         const world::WorldGenerator& generator,
+                         const std::unordered_set<ChunkCoord>& stored,
+                         world::RegionStore& store)
+{
+    std::unordered_map<ChunkCoord, TileChunk> chunks;
+    const auto for_each = [&](int margin, auto&& fn) {
+        for (int z = tile.min.z - margin; z < tile.max.z + margin; ++z)
+        {
+            for (int x = tile.min.x - margin; x < tile.max.x + margin; ++x)
+            {
+                fn(ChunkCoord{x, z});
+            }
+        }
+    };
+
+    for_each(2, [&](const ChunkCoord& coord) {
+        TileChunk& entry = chunks[coord];
+        entry.chunk = std::make_shared<world::Chunk>(coord);
+        generator.generate_chunk(*entry.chunk);
+        world::Decorator::decorate(*entry.chunk, generator, entry.decorations);
+    });
+
+    for_each(1, [&](const ChunkCoord& coord) {
+        world::Chunk& chunk = *chunks.at(coord).chunk;
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                world::Decorator::apply(chunk, chunks.at({coord.x + dx, coord.z + dz}).decorations);
+            }
+        }
+    });
+
+    world::LightEngine light([&chunks](const ChunkCoord& coord) -> world::Chunk* {
+        auto it = chunks.find(coord);
+        return it != chunks.end() && it->second.chunk->lit() ? it->second.chunk.get() : nullptr;
+    });
+    // Nothing is meshed here, so which chunks the light reached does not matter.
+    std::vector<ChunkCoord> touched;
+    std::vector<world::LitBorder> litBorders;
+    for_each(1, [&](const ChunkCoord& coord) {
+        touched.clear();
+        litBorders.clear();
+        light.light_chunk(chunks.at(coord).chunk, touched, litBorders);
+    });
+
+    std::size_t written = 0;
+    for_each(0, [&](const ChunkCoord& coord) {
+        if (stored.contains(coord))
+            return;
+
+        // The decorations go along so a live world can still finalize chunks next to these.
+        const TileChunk& entry = chunks.at(coord);
+        const world::Chunk& chunk = *entry.chunk;
+        std::vector<std::uint8_t> record;
+        world::ChunkCodec::encode_record(chunk, true, entry.decorations, record);
+        store.save(coord, std::move(record));
+        ++written;
+    });
+    return written;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    world::WorldGenerator generator;
+    generator.set_config(options.config);
+
+    world::RegionStore store(options.output, options.config.fingerprint());
+
+    // Area [min, min + size) in both axes, cut into tiles; tiles with nothing left are dropped.
+    const ChunkCoord min{options.center.x - options.size / 2, options.center.z - options.size / 2};
+    const ChunkCoord max{min.x + options.size, min.z + options.size};
+    std::unordered_set<ChunkCoord> stored;
+    for (int z = min.z; z < max.z; ++z)
+    {
+        for (int x = min.x; x < max.x; ++x)
+        {
+            if (!store.writable({x, z}))
+            {
+                util::log().error("%s holds regions of another world config or cannot be written", options.output.c_str());
+                return 1;
+            }
+            if (store.contains({x, z}))
+                stored.insert({x, z});
+        }
+    }
+
+    std::vector<Tile> tiles;
+    std::size_t remaining = 0;
+    for (int z = min.z; z < max.z; z += options.tile)
+    {
+        for (int x = min.x; x < max.x; x += options.tile)
+        {
+            const Tile tile{{x, z}, {std::min(x + options.tile, max.x), std::min(z + options.tile, max.z)}};
+            std::size_t missing = 0;
+            for (int cz = tile.min.z; cz < tile.max.z; ++cz)
+            {
+                for (int cx = tile.min.x; cx < tile.max.x; ++cx)
+                {
+                    missing += !stored.contains({cx, cz});
+                }
+            }
+            if (missing > 0)
+                tiles.push_back(tile);
+            remaining += missing;
+        }
+    }
+
+    const std::size_t total = static_cast<std::size_t>(options.size) * static_cast<std::size_t>(options.size);
+    util::log().info("Pregenerating %zu chunks around (%d, %d) into %s: %zu already stored, %zu tiles on %u threads",
+                     total,
+                     options.center.x,
+                     options.center.z,
+                     options.output.c_str(),
+                     total - remaining,
+                     tiles.size(),
+                     options.threads);
+
+    std::atomic<std::size_t> nextTile{0};
+    std::atomic<std::size_t> done{0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < options.threads; ++i)
+    {
+        workers.emplace_back([&]() {
+            for (std::size_t index = nextTile++; index < tiles.size(); index = nextTile++)
+            {
+                done += process_tile(tiles[index], generator, stored, store);
+            }
+        });
+    }
+
+    const auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    double lastReport = 0.0;
+    while (done.load() < remaining)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (elapsed() - lastReport >= 1.0)
+        {
+            lastReport = elapsed();
+            const std::size_t count = done.load();
+            util::log().info("%zu / %zu chunks, %.0f chunks/s", count, remaining, static_cast<double>(count) / lastReport);
+        }
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    store.flush();
+
+    const double seconds = elapsed();
+    std::uintmax_t bytes = 0;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(options.output, error))
+    {
+        if (file.path().extension() == ".ccr")
+            bytes += file.file_size(error);
+    }
+    const double mebibytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    util::log().info("Done: %zu chunks in %.2f s (%.0f chunks/s); %s is %.1f MiB",
+                     remaining,
+                     seconds,
+                     seconds > 0.0 ? static_cast<double>(remaining) / seconds : 0.0,
+                     options.output.c_str(),
+                     mebibytes);
+    return 0;
+}
@@ -11,4 +11,23 @@ constexpr std::size_t hash_combine(std::size_t seed, std::size_t value)
     return seed;
 }
 
+// SplitMix64 finaliser: well-distributed bits for deterministic per-position randomness.
+constexpr std::uint64_t mix64(std::uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// 64-bit FNV-1a over a byte range; cheap integrity checks for data written to disk.
+constexpr std::uint64_t fnv1a(const std::uint8_t* data, std::size_t size, std::uint64_t hash = 0xcbf29ce484222325ull)
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
 } // namespace util
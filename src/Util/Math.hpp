@@ -15,6 +15,12 @@ inline glm::mat4 look_at(const glm::vec3& pos, const glm::vec3& target, const gl
     return glm::lookAt(pos, target, up);
 }
 
+// Integer division rounding towards negative infinity (world column -> chunk or region).
+inline int floor_div(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
 inline glm::vec3 direction_from_euler(float pitch, float yaw)
 {
     const glm::vec3 front{
@@ -31,4 +31,11 @@ inline AtlasUV atlas_uv(const BlockFaceUV& tile)
     return {glm::vec2{u0, v0}, glm::vec2{u1, v1}};
 }
 
+// Layer of a tile in the block texture array built by renderer::Texture::load_array.
+inline std::uint8_t tile_layer(const BlockFaceUV& tile)
+{
+    const auto atlas = config::atlas();
+    return static_cast<std::uint8_t>(tile.tileY * atlas.tilesX + tile.tileX);
+}
+
 } // namespace world
@@ -0,0 +1,197 @@
+#include "BiomeMap.hpp"
+
+#include "Util/Math.hpp"
+
+#include <algorithm>
+
+#include <FastNoiseLite.h>
+
+namespace world
+{
+namespace
+{
+Biome classify(float temperature, float humidity)
+{
+    if (temperature < -0.35f)
+        return Biome::Tundra;
+    if (temperature > 0.35f && humidity < 0.0f)
+        return Biome::Desert;
+    if (humidity > 0.3f)
+        return Biome::Forest;
+    return Biome::Plains;
+}
+
+struct ClimateNoise
+{
+    ClimateNoise(int seed, float frequency) : temperature(seed + 101), humidity(seed + 211)
+    {
+        for (FastNoiseLite* noise : {&temperature, &humidity})
+        {
+            noise->SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+            noise->SetFrequency(frequency);
+            noise->SetFractalType(FastNoiseLite::FractalType_FBm);
+            noise->SetFractalOctaves(3);
+        }
+    }
+
+    FastNoiseLite temperature;
+    FastNoiseLite humidity;
+};
+} // namespace
+
+BiomeMap::BiomeMap(std::size_t capacity) : m_capacity(std::max<std::size_t>(capacity, 1))
+{
+}
+
+void BiomeMap::configure(int seed, float frequency)
+{
+    std::lock_guard lock(m_mutex);
+    m_seed = seed;
+    m_frequency = frequency;
+    m_lru.clear();
+    m_index.clear();
+}
+
+BiomeMap::TilePtr BiomeMap::build_tile(const ChunkCoord& region, int seed, float frequency) const
+{
+    // Tiles are built rarely (once per RegionSize^2 columns), so a local noise object per
+    // build keeps workers independent without any per-thread state.
+    const ClimateNoise noise(seed, frequency);
+
+    auto tile = std::make_shared<RegionTile>();
+    const int originX = region.x * RegionSize;
+    const int originZ = region.z * RegionSize;
+    for (int j = 0; j < SamplesPerAxis; ++j)
+    {
+        for (int i = 0; i < SamplesPerAxis; ++i)
+        {
+            const float x = static_cast<float>(originX + i * SampleSpacing);
+            const float z = static_cast<float>(originZ + j * SampleSpacing);
+            const std::size_t index = static_cast<std::size_t>(i + j * SamplesPerAxis);
+            tile->temperature[index] = noise.temperature.GetNoise(x, z);
+            tile->humidity[index] = noise.humidity.GetNoise(x, z);
+        }
+    }
+    return tile;
+}
+
+BiomeMap::TilePtr BiomeMap::region_tile(const ChunkCoord& region) const
+{
+    int seed = 0;
+    float frequency = 0.0f;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_index.find(region);
+        if (it != m_index.end())
+        {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return it->second->tile;
+        }
+        seed = m_seed;
+        frequency = m_frequency;
+    }
+
+    // Built outside the lock; if two workers miss the same region at once the second insert
+    // simply adopts the tile that landed first.
+    TilePtr tile = build_tile(region, seed, frequency);
+
+    std::lock_guard lock(m_mutex);
+    if (seed != m_seed || frequency != m_frequency)
+        return tile; // reconfigured meanwhile; do not cache a stale tile
+
+    auto it = m_index.find(region);
+    if (it != m_index.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->tile;
+    }
+
+    m_lru.push_front({region, tile});
+    m_index.emplace(region, m_lru.begin());
+    if (m_lru.size() > m_capacity)
+    {
+        m_index.erase(m_lru.back().region);
+        m_lru.pop_back();
+    }
+    return tile;
+}
+
+void BiomeMap::sample(int originX, int originZ, int width, int depth, ClimateSample* out, int step) const
+{
+    if (step % SampleSpacing == 0 && originX % SampleSpacing == 0 && originZ % SampleSpacing == 0)
+    {
+        sample_lattice(originX, originZ, width, depth, step, out);
+        return;
+    }
+
+    ChunkCoord currentRegion{};
+    TilePtr tile;
+    for (int z = 0; z < depth; ++z)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int worldX = originX + x * step;
+            const int worldZ = originZ + z * step;
+            const ChunkCoord region{util::floor_div(worldX, RegionSize), util::floor_div(worldZ, RegionSize)};
+            if (!tile || region != currentRegion)
+            {
+                tile = region_tile(region);
+                currentRegion = region;
+            }
+
+            const int localX = worldX - region.x * RegionSize;
+            const int localZ = worldZ - region.z * RegionSize;
+            const int cellX = localX / SampleSpacing;
+            const int cellZ = localZ / SampleSpacing;
+            const float fx = static_cast<float>(localX - cellX * SampleSpacing) / SampleSpacing;
+            const float fz = static_cast<float>(localZ - cellZ * SampleSpacing) / SampleSpacing;
+
+            const auto bilinear = [&](const auto& field) {
+                const std::size_t i00 = static_cast<std::size_t>(cellX + cellZ * SamplesPerAxis);
+                const float top = field[i00] + (field[i00 + 1] - field[i00]) * fx;
+                const float bottom = field[i00 + SamplesPerAxis] + (field[i00 + SamplesPerAxis + 1] - field[i00 + SamplesPerAxis]) * fx;
+                return top + (bottom - top) * fz;
+            };
+
+            ClimateSample& sample = out[static_cast<std::size_t>(x + z * width)];
+            sample.temperature = bilinear(tile->temperature);
+            sample.humidity = bilinear(tile->humidity);
+            sample.biome = classify(sample.temperature, sample.humidity);
+        }
+    }
+}
+
+// Every point sits on the region sample lattice, where bilinear interpolation returns the
+// lattice value itself, so evaluating the noise here matches the cached path exactly.
+void BiomeMap::sample_lattice(int originX, int originZ, int width, int depth, int step, ClimateSample* out) const
+{
+    int seed = 0;
+    float frequency = 0.0f;
+    {
+        std::lock_guard lock(m_mutex);
+        seed = m_seed;
+        frequency = m_frequency;
+    }
+
+    const ClimateNoise noise(seed, frequency);
+    for (int z = 0; z < depth; ++z)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float worldX = static_cast<float>(originX + x * step);
+            const float worldZ = static_cast<float>(originZ + z * step);
+            ClimateSample& sample = out[static_cast<std::size_t>(x + z * width)];
+            sample.temperature = noise.temperature.GetNoise(worldX, worldZ);
+            sample.humidity = noise.humidity.GetNoise(worldX, worldZ);
+            sample.biome = classify(sample.temperature, sample.humidity);
+        }
+    }
+}
+
+std::size_t BiomeMap::cached_regions() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_lru.size();
+}
+
+} // namespace world
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ChunkCoord.hpp"
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace world
+{
+enum class Biome : std::uint8_t
+{
+    Plains,
+    Forest,
+    Desert,
+    Tundra
+};
+
+struct ClimateSample
+{
+    float temperature = 0.0f; // roughly [-1, 1], cold to hot
+    float humidity = 0.0f;    // roughly [-1, 1], dry to wet
+    Biome biome = Biome::Plains;
+};
+
+// Low-frequency climate fields for biome selection. Temperature and humidity are sampled once
+// per region of RegionSize x RegionSize columns on a coarse SampleSpacing grid and bilinearly
+// interpolated per column. Region tiles live in a bounded LRU cache shared by every
+// generation worker, so neighbouring chunks reuse a tile instead of re-sampling noise.
+class BiomeMap
+{
+  public:
+    static constexpr int RegionSize = 256;
+    static constexpr int SampleSpacing = 16;
+
+    explicit BiomeMap(std::size_t capacity = 64);
+
+    // Changes the climate noise and drops every cached region.
+    void configure(int seed, float frequency);
+
+    // Climate for width x depth columns starting at world column (originX, originZ) and spaced
+    // step columns apart, written row-major with x fastest. Thread-safe. Grids that only hit
+    // the coarse sample lattice (distant terrain) read the noise directly instead of caching
+    // the many regions they span; the values are identical.
+    void sample(int originX, int originZ, int width, int depth, ClimateSample* out, int step = 1) const;
+
+    std::size_t cached_regions() const;
+
+  private:
+    static constexpr int SamplesPerAxis = RegionSize / SampleSpacing + 1;
+
+    struct RegionTile
+    {
+        std::array<float, SamplesPerAxis * SamplesPerAxis> temperature{};
+        std::array<float, SamplesPerAxis * SamplesPerAxis> humidity{};
+    };
+    using TilePtr = std::shared_ptr<const RegionTile>;
+
+    struct CacheEntry
+    {
+        ChunkCoord region; // region coordinates, i.e. world column / RegionSize
+        TilePtr tile;
+    };
+
+    TilePtr region_tile(const ChunkCoord& region) const;
+    TilePtr build_tile(const ChunkCoord& region, int seed, float frequency) const;
+    void sample_lattice(int originX, int originZ, int width, int depth, int step, ClimateSample* out) const;
+
+    std::size_t m_capacity;
+    int m_seed = 0;
+    float m_frequency = 0.0f;
+
+    mutable std::mutex m_mutex;
+    mutable std::list<CacheEntry> m_lru; // most recently used at the front
+    mutable std::unordered_map<ChunkCoord, std::list<CacheEntry>::iterator> m_index;
+};
+
+} // namespace world
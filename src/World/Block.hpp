@@ -43,8 +43,13 @@ struct BlockDefinition
     std::string_view name{};
     std::uint8_t flags = BlockFlags::Opaque;
     std::array<BlockFaceUV, static_cast<int>(BlockFace::Count)> faces{};
+    // Light levels run 0-15. Opacity is the extra attenuation light suffers entering the block
+    // (15 blocks it entirely); emission is the block light level the block gives off.
+    std::uint8_t lightOpacity = 15;
+    std::uint8_t lightEmission = 0;
 };
 
 constexpr BlockID BlockAir = 0;
+constexpr std::uint8_t MaxLightLevel = 15;
 
 } // namespace world
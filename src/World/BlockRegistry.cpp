@@ -6,12 +6,23 @@ namespace world
 {
 namespace
 {
-BlockDefinition make_block(std::string_view name, std::uint8_t flags, const BlockFaceUV& uv)
+std::uint8_t default_opacity(std::uint8_t flags)
+{
+    if (has_flag(flags, BlockFlags::Fluid))
+        return 2;
+    if (has_flag(flags, BlockFlags::Transparent))
+        return 0;
+    return MaxLightLevel;
+}
+
+BlockDefinition make_block(std::string_view name, std::uint8_t flags, const BlockFaceUV& uv, std::uint8_t emission = 0)
 {
     BlockDefinition def;
     def.name = name;
     def.flags = flags;
     def.faces.fill(uv);
+    def.lightOpacity = default_opacity(flags);
+    def.lightEmission = emission;
     return def;
 }
 
@@ -26,6 +37,7 @@ BlockDefinition make_block(std::string_view name, std::uint8_t flags, const Bloc
     def.faces[static_cast<int>(BlockFace::NegX)] = side;
     def.faces[static_cast<int>(BlockFace::PosZ)] = side;
     def.faces[static_cast<int>(BlockFace::NegZ)] = side;
+    def.lightOpacity = default_opacity(flags);
     return def;
 }
 } // namespace
@@ -38,6 +50,7 @@ BlockRegistry::BlockRegistry()
     BlockDefinition air;
     air.name = "air";
     air.flags = BlockFlags::Transparent;
+    air.lightOpacity = 0;
     m_blocks.push_back(air);
 
     m_blocks.push_back(make_block("grass", BlockFlags::Opaque, BlockFaceUV{0, 0}, BlockFaceUV{1, 0}, BlockFaceUV{2, 0}));
@@ -46,6 +59,9 @@ BlockRegistry::BlockRegistry()
     m_blocks.push_back(make_block("water", BlockFlags::Transparent | BlockFlags::Fluid, BlockFaceUV{0, 1}));
     m_blocks.push_back(make_block("sand", BlockFlags::Opaque, BlockFaceUV{1, 1}));
     m_blocks.push_back(make_block("snow", BlockFlags::Opaque, BlockFaceUV{2, 1}));
+    m_blocks.push_back(make_block("glowstone", BlockFlags::Opaque, BlockFaceUV{3, 1}, MaxLightLevel));
+    m_blocks.push_back(make_block("log", BlockFlags::Opaque, BlockFaceUV{1, 2}, BlockFaceUV{0, 2}, BlockFaceUV{1, 2}));
+    m_blocks.push_back(make_block("leaves", BlockFlags::Opaque, BlockFaceUV{2, 2}));
 }
 
 const BlockDefinition& BlockRegistry::definition(BlockID id) const
@@ -60,6 +76,18 @@ std::uint8_t BlockRegistry::flags(BlockID id) const
     return m_blocks[id].flags;
 }
 
+std::uint8_t BlockRegistry::light_opacity(BlockID id) const
+{
+    assert(id < m_blocks.size());
+    return m_blocks[id].lightOpacity;
+}
+
+std::uint8_t BlockRegistry::light_emission(BlockID id) const
+{
+    assert(id < m_blocks.size());
+    return m_blocks[id].lightEmission;
+}
+
 const BlockRegistry& registry()
 {
     static BlockRegistry g_registry;
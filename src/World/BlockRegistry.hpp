@@ -13,6 +13,8 @@ class BlockRegistry
 
     const BlockDefinition& definition(BlockID id) const;
     std::uint8_t flags(BlockID id) const;
+    std::uint8_t light_opacity(BlockID id) const;
+    std::uint8_t light_emission(BlockID id) const;
 
   private:
     std::vector<BlockDefinition> m_blocks;
@@ -28,18 +28,75 @@ void Chunk::set(int x, int y, int z, BlockID id)
     }
 }
 
+void Chunk::fill_section(int index, BlockID id)
+{
+    m_sections[index].fill(id);
+    for (auto& dirty : m_dirty)
+    {
+        dirty.store(true, std::memory_order_relaxed);
+    }
+}
+
+void Chunk::set_layer(int y, const BlockID* blocks)
+{
+    m_sections[section_index(y)].set_layer(y % SectionSize, blocks);
+    for (auto& dirty : m_dirty)
+    {
+        dirty.store(true, std::memory_order_relaxed);
+    }
+}
+
+int Chunk::content_height() const
+{
+    for (int index = SectionCount - 1; index >= 0; --index)
+    {
+        if (!m_sections[index].empty())
+            return (index + 1) * SectionSize;
+    }
+    return 0;
+}
+
+int Chunk::allocated_sections() const
+{
+    int count = 0;
+    for (const ChunkSection& section : m_sections)
+    {
+        count += section.allocated();
+    }
+    return count;
+}
+
+std::uint8_t Chunk::light(int x, int y, int z) const
+{
+    if (y >= ChunkHeight)
+        return static_cast<std::uint8_t>(MaxLightLevel << 4);
+    if (y < 0)
+        return 0;
+    return m_sections[section_index(y)].light(x, y % SectionSize, z);
+}
+
+void Chunk::set_light(int x, int y, int z, std::uint8_t packed)
+{
+    m_sections[section_index(y)].set_light(x, y % SectionSize, z, packed);
+}
+
+// mark_dirty and these reads are sequentially consistent: the streamer pairs them with its
+// meshInFlight flag so a chunk dirtied while its mesh job finishes is always picked up by one
+// side or the other. The block setters only store relaxed; they run while a chunk generates,
+// when no mesh job can be in flight, or ahead of an edit's invalidate_mesh, whose mark_dirty
+// is the store that pairing relies on.
 bool Chunk::needs_remesh(std::uint8_t lod) const
 {
     if (lod >= m_dirty.size())
         return false;
-    return m_dirty[lod].load(std::memory_order_relaxed);
+    return m_dirty[lod].load();
 }
 
 void Chunk::mark_dirty(std::uint8_t lod)
 {
     if (lod < m_dirty.size())
     {
-        m_dirty[lod].store(true, std::memory_order_relaxed);
+        m_dirty[lod].store(true);
     }
 }
 
@@ -51,6 +108,11 @@ void Chunk::clear_dirty(std::uint8_t lod) const
     }
 }
 
+bool Chunk::take_dirty(std::uint8_t lod) const
+{
+    return lod < m_dirty.size() && m_dirty[lod].exchange(false);
+}
+
 glm::vec3 Chunk::world_position() const
 {
     return {static_cast<float>(m_coord.x * ChunkWidth), 0.0f, static_cast<float>(m_coord.z * ChunkDepth)};
@@ -27,6 +27,17 @@ enum class ChunkState : std::uint8_t
     Visible
 };
 
+// Progress through the generation pipeline while a chunk is ChunkState::Generating: terrain
+// is written, decoration writes are computed, and finalize applies the decoration writes of
+// the chunk and its neighbours and lights the result.
+enum class GenerationStage : std::uint8_t
+{
+    None,
+    Terrain,
+    Decorated,
+    Finalized
+};
+
 // Represents a single column of 16x256x16 blocks, internally chunked into 16x16x16 sections.
 // The state machine progresses from Unloaded -> Generating -> MeshPending -> Uploaded.
 // Uploaded chunks are ready for rendering; once rendered they may be marked Visible.
@@ -39,6 +50,23 @@ class Chunk
     BlockID get(int x, int y, int z) const;
     void set(int x, int y, int z, BlockID id);
 
+    // Bulk writes used by generation; both mark every LOD dirty like set() does.
+    void fill_section(int index, BlockID id);
+    void set_layer(int y, const BlockID* blocks);
+
+    // One past the highest y that may hold a non-air block (0 when the column is empty).
+    int content_height() const;
+    // Sections holding per-cell storage (see ChunkSection).
+    int allocated_sections() const;
+
+    // Packed sky/block light (see ChunkSection). Above the column everything is open sky.
+    std::uint8_t light(int x, int y, int z) const;
+    void set_light(int x, int y, int z, std::uint8_t packed);
+
+    // Set once LightEngine has flooded the chunk; only lit chunks exchange light with neighbours.
+    bool lit() const { return m_lit.load(std::memory_order_acquire); }
+    void set_lit(bool lit) { m_lit.store(lit, std::memory_order_release); }
+
     ChunkSection& section(int index) { return m_sections[index]; }
     const ChunkSection& section(int index) const { return m_sections[index]; }
 
@@ -47,9 +75,15 @@ class Chunk
     ChunkState state() const { return m_state.load(std::memory_order_relaxed); }
     void set_state(ChunkState state) { m_state.store(state, std::memory_order_relaxed); }
 
+    // Release/acquire so whatever a stage produced is visible to anyone who sees its stage.
+    GenerationStage stage() const { return m_stage.load(std::memory_order_acquire); }
+    void set_stage(GenerationStage stage) { m_stage.store(stage, std::memory_order_release); }
+
     bool needs_remesh(std::uint8_t lod) const;
     void mark_dirty(std::uint8_t lod);
     void clear_dirty(std::uint8_t lod) const;
+    // Clears the flag and returns whether it was set.
+    bool take_dirty(std::uint8_t lod) const;
 
     glm::vec3 world_position() const;
 
@@ -60,6 +94,8 @@ class Chunk
     std::array<ChunkSection, SectionCount> m_sections{};
     mutable std::array<std::atomic_bool, 3> m_dirty{};
     std::atomic<ChunkState> m_state{ChunkState::Unloaded};
+    std::atomic<GenerationStage> m_stage{GenerationStage::None};
+    std::atomic_bool m_lit{false};
 };
 
 using ChunkPtr = std::shared_ptr<Chunk>;
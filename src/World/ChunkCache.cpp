@@ -0,0 +1,162 @@
+#include "ChunkCache.hpp"
+
+#include "ChunkCodec.hpp"
+
+namespace world
+{
+ChunkCache::ChunkCache(std::size_t budgetBytes) : m_budgetBytes(budgetBytes)
+{
+}
+
+void ChunkCache::insert_raw(const ChunkPtr& chunk, std::vector<BlockWrite> decorations, bool unsaved)
+{
+    Entry entry;
+    entry.raw = chunk;
+    entry.rawDecorations = std::move(decorations);
+    entry.rawUnsaved = unsaved;
+    entry.bytes = sizeof(Chunk) + entry.rawDecorations.capacity() * sizeof(BlockWrite);
+
+    std::lock_guard lock(m_mutex);
+    add_locked(chunk->coord(), std::move(entry));
+}
+
+void ChunkCache::insert(const ChunkCoord& coord, std::shared_ptr<const CachedChunk> cached)
+{
+    Entry entry;
+    entry.bytes = cached->bytes();
+    entry.cached = std::move(cached);
+
+    std::lock_guard lock(m_mutex);
+    add_locked(coord, std::move(entry));
+}
+
+std::shared_ptr<const CachedChunk> ChunkCache::compress(const ChunkPtr& chunk)
+{
+    std::vector<BlockWrite> decorations;
+    bool unsaved = false;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_entries.find(chunk->coord());
+        if (it == m_entries.end() || it->second.raw != chunk)
+            return nullptr;
+        decorations = it->second.rawDecorations;
+        unsaved = it->second.rawUnsaved;
+    }
+
+    // The chunk left the grid, so nothing writes to it any more; encoding runs unlocked.
+    auto cached = encode(*chunk, decorations, false);
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_entries.find(chunk->coord());
+    if (it == m_entries.end() || it->second.raw != chunk)
+        return nullptr;
+
+    Entry& entry = it->second;
+    m_bytes -= entry.bytes;
+    entry.raw.reset();
+    entry.rawDecorations = {};
+    entry.bytes = cached->bytes();
+    entry.cached = cached;
+    m_bytes += entry.bytes;
+    evict_locked();
+    return unsaved ? cached : nullptr;
+}
+
+std::vector<std::pair<ChunkCoord, std::shared_ptr<const CachedChunk>>> ChunkCache::take_unsaved()
+{
+    std::vector<std::pair<ChunkCoord, std::shared_ptr<const CachedChunk>>> unsaved;
+    std::lock_guard lock(m_mutex);
+    for (auto& [coord, entry] : m_entries)
+    {
+        if (entry.raw && entry.rawUnsaved)
+        {
+            unsaved.emplace_back(coord, encode(*entry.raw, entry.rawDecorations, true));
+            entry.rawUnsaved = false;
+        }
+        else if (entry.cached && entry.cached->unsaved)
+        {
+            unsaved.emplace_back(coord, entry.cached);
+        }
+    }
+    return unsaved;
+}
+
+std::shared_ptr<const CachedChunk> ChunkCache::take(const ChunkCoord& coord)
+{
+    ChunkPtr raw;
+    std::vector<BlockWrite> decorations;
+    bool unsaved = false;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_entries.find(coord);
+        if (it == m_entries.end())
+            return nullptr;
+
+        auto cached = std::move(it->second.cached);
+        raw = std::move(it->second.raw);
+        decorations = std::move(it->second.rawDecorations);
+        unsaved = it->second.rawUnsaved;
+        erase_locked(it);
+        if (cached)
+            return cached;
+    }
+    return encode(*raw, decorations, unsaved);
+}
+
+std::size_t ChunkCache::size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
+
+std::size_t ChunkCache::bytes() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_bytes;
+}
+
+std::shared_ptr<const CachedChunk> ChunkCache::encode(const Chunk& chunk, const std::vector<BlockWrite>& decorations, bool unsaved)
+{
+    // Light is left out: a restored chunk is lit again against whatever neighbours it finds.
+    auto cached = std::make_shared<CachedChunk>();
+    ChunkCodec::encode_record(chunk, false, decorations, cached->record);
+    cached->record.shrink_to_fit();
+    cached->unsaved = unsaved;
+    return cached;
+}
+
+void ChunkCache::add_locked(const ChunkCoord& coord, Entry entry)
+{
+    if (auto it = m_entries.find(coord); it != m_entries.end())
+        erase_locked(it);
+
+    m_age.push_front(coord);
+    entry.age = m_age.begin();
+    m_bytes += entry.bytes;
+    m_entries.emplace(coord, std::move(entry));
+    evict_locked();
+}
+
+// Oldest first, skipping raw entries: their compress job is queued and they shrink soon.
+void ChunkCache::evict_locked()
+{
+    for (auto age = m_age.end(); m_bytes > m_budgetBytes && age != m_age.begin();)
+    {
+        --age;
+        auto it = m_entries.find(*age);
+        if (it->second.raw)
+            continue;
+        age = m_age.erase(age);
+        m_bytes -= it->second.bytes;
+        m_entries.erase(it);
+    }
+}
+
+void ChunkCache::erase_locked(std::unordered_map<ChunkCoord, Entry>::iterator it)
+{
+    m_bytes -= it->second.bytes;
+    m_age.erase(it->second.age);
+    m_entries.erase(it);
+}
+
+} // namespace world
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "Decorator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace world
+{
+// A finished chunk as a ChunkCodec record: its blocks and the decoration writes its
+// neighbours need to finalize next to it. Immutable once created.
+struct CachedChunk
+{
+    std::vector<std::uint8_t> record;
+    // Generated or edited since it was last written to the region store.
+    bool unsaved = false;
+
+    std::size_t bytes() const { return record.capacity(); }
+};
+
+// Warm residency tier for chunks that left the unload radius, in front of the region files.
+// A chunk arrives raw and is compressed by a worker shortly after; coming back within reach
+// restores it from here instead of loading or generating it again, edits included. Least
+// recently unloaded chunks are dropped once the cache exceeds its byte budget; raw ones wait
+// for their compression, which is already queued. Thread-safe.
+class ChunkCache
+{
+  public:
+    explicit ChunkCache(std::size_t budgetBytes);
+
+    // Keeps a finished chunk as is until compress() runs for it.
+    void insert_raw(const ChunkPtr& chunk, std::vector<BlockWrite> decorations, bool unsaved);
+    // Puts back a payload that was taken but never restored.
+    void insert(const ChunkCoord& coord, std::shared_ptr<const CachedChunk> cached);
+    // Encodes a chunk handed to insert_raw(); does nothing if it has been taken since. An
+    // unsaved chunk's payload is returned for the caller to persist, and the cached copy
+    // counts as saved from then on.
+    std::shared_ptr<const CachedChunk> compress(const ChunkPtr& chunk);
+    // Encodes every chunk still raw, as when their compress jobs will never run, and returns
+    // every payload with unsaved changes; for shutdown.
+    std::vector<std::pair<ChunkCoord, std::shared_ptr<const CachedChunk>>> take_unsaved();
+
+    // Removes and returns the coordinate's payload, or null. A chunk still raw is encoded on
+    // the spot, which only happens when the camera turns back within moments.
+    std::shared_ptr<const CachedChunk> take(const ChunkCoord& coord);
+
+    std::size_t size() const;
+    std::size_t bytes() const;
+
+  private:
+    struct Entry
+    {
+        ChunkPtr raw;
+        std::vector<BlockWrite> rawDecorations;
+        bool rawUnsaved = false;
+        std::shared_ptr<const CachedChunk> cached;
+        std::size_t bytes = 0;
+        std::list<ChunkCoord>::iterator age;
+    };
+
+    static std::shared_ptr<const CachedChunk> encode(const Chunk& chunk, const std::vector<BlockWrite>& decorations, bool unsaved);
+    void add_locked(const ChunkCoord& coord, Entry entry);
+    void evict_locked();
+    void erase_locked(std::unordered_map<ChunkCoord, Entry>::iterator it);
+
+    std::size_t m_budgetBytes;
+    mutable std::mutex m_mutex;
+    std::unordered_map<ChunkCoord, Entry> m_entries;
+    // Most recently inserted at the front.
+    std::list<ChunkCoord> m_age;
+    std::size_t m_bytes = 0;
+};
+
+} // namespace world
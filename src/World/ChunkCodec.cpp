@@ -0,0 +1,246 @@
+#include "ChunkCodec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace world
+{
+namespace
+{
+constexpr std::uint8_t FlagLight = 1u << 0;
+
+enum SectionTag : std::uint8_t
+{
+    Uniform = 0,
+    Runs = 1
+};
+
+template <typename T> void put(std::vector<std::uint8_t>& out, T value)
+{
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+class Reader
+{
+  public:
+    Reader(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T> bool get(T& value)
+    {
+        if (m_size - m_offset < sizeof(T))
+            return false;
+        std::memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool done() const { return m_offset == m_size; }
+
+  private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_offset = 0;
+};
+
+// Record prefix; the chunk and the decorations follow.
+struct RecordHeader
+{
+    std::uint32_t chunkBytes = 0;
+    std::uint32_t decorationCount = 0;
+};
+
+// BlockWrite with a fixed layout.
+struct StoredWrite
+{
+    std::int32_t x = 0;
+    std::int32_t y = 0;
+    std::int32_t z = 0;
+    BlockID block = BlockAir;
+    std::uint8_t soft = 0;
+    std::uint8_t reserved = 0;
+};
+
+template <typename T> void encode_values(const T* values, std::vector<std::uint8_t>& out)
+{
+    std::size_t runs = 1;
+    for (std::size_t i = 1; i < SectionVolume; ++i)
+    {
+        runs += values[i] != values[i - 1];
+    }
+
+    if (runs == 1)
+    {
+        put(out, Uniform);
+        put(out, values[0]);
+        return;
+    }
+
+    put(out, Runs);
+    put(out, static_cast<std::uint16_t>(runs));
+    std::size_t start = 0;
+    for (std::size_t i = 1; i <= SectionVolume; ++i)
+    {
+        if (i == SectionVolume || values[i] != values[start])
+        {
+            put(out, values[start]);
+            put(out, static_cast<std::uint16_t>(i - start));
+            start = i;
+        }
+    }
+}
+
+template <typename T> void encode_section(const T* values, T uniform, std::vector<std::uint8_t>& out)
+{
+    if (values)
+    {
+        encode_values(values, out);
+        return;
+    }
+    put(out, Uniform);
+    put(out, uniform);
+}
+
+// Uniform sections report their value through `uniform` and leave `values` untouched.
+template <typename T> bool decode_values(Reader& reader, std::array<T, SectionVolume>& values, bool& isUniform, T& uniform)
+{
+    std::uint8_t tag = 0;
+    if (!reader.get(tag))
+        return false;
+
+    isUniform = tag == Uniform;
+    if (isUniform)
+        return reader.get(uniform);
+    if (tag != Runs)
+        return false;
+
+    std::uint16_t runs = 0;
+    if (!reader.get(runs))
+        return false;
+
+    std::size_t filled = 0;
+    for (std::uint16_t run = 0; run < runs; ++run)
+    {
+        T value{};
+        std::uint16_t length = 0;
+        if (!reader.get(value) || !reader.get(length) || length > SectionVolume - filled)
+            return false;
+        std::fill_n(values.begin() + static_cast<std::ptrdiff_t>(filled), length, value);
+        filled += length;
+    }
+    return filled == SectionVolume;
+}
+} // namespace
+
+void ChunkCodec::encode(const Chunk& chunk, bool withLight, std::vector<std::uint8_t>& out)
+{
+    put(out, static_cast<std::uint8_t>(withLight ? FlagLight : 0));
+    for (int index = 0; index < SectionCount; ++index)
+    {
+        const ChunkSection& section = chunk.section(index);
+        // Unallocated sections are uniform by construction and need no scan.
+        encode_section(section.blocks(), section.get(0, 0, 0), out);
+        if (withLight)
+            encode_section(section.light_values(), section.light(0, 0, 0), out);
+    }
+}
+
+bool ChunkCodec::decode(const std::uint8_t* data, std::size_t size, Chunk& chunk)
+{
+    Reader reader(data, size);
+    std::uint8_t flags = 0;
+    if (!reader.get(flags))
+        return false;
+
+    std::array<BlockID, SectionVolume> blocks{};
+    std::array<std::uint8_t, SectionVolume> light{};
+    for (int index = 0; index < SectionCount; ++index)
+    {
+        bool isUniform = false;
+        BlockID block = BlockAir;
+        if (!decode_values(reader, blocks, isUniform, block))
+            return false;
+
+        // Sections start as air, so uniform air needs no work at all.
+        if (isUniform && block != BlockAir)
+        {
+            chunk.fill_section(index, block);
+        }
+        else if (!isUniform)
+        {
+            for (int y = 0; y < SectionSize; ++y)
+            {
+                chunk.set_layer(index * SectionSize + y, blocks.data() + y * SectionLayerArea);
+            }
+        }
+
+        if (flags & FlagLight)
+        {
+            std::uint8_t packed = 0;
+            if (!decode_values(reader, light, isUniform, packed))
+                return false;
+            ChunkSection& section = chunk.section(index);
+            if (isUniform)
+            {
+                section.fill_light(packed);
+                continue;
+            }
+            for (int y = 0; y < SectionSize; ++y)
+            {
+                section.set_light_layer(y, light.data() + y * SectionLayerArea);
+            }
+        }
+    }
+
+    if (flags & FlagLight)
+        chunk.set_lit(true);
+    return reader.done();
+}
+
+void ChunkCodec::encode_record(const Chunk& chunk, bool withLight, const std::vector<BlockWrite>& decorations, std::vector<std::uint8_t>& out)
+{
+    const std::size_t headerOffset = out.size();
+    put(out, RecordHeader{});
+    const std::size_t chunkOffset = out.size();
+    encode(chunk, withLight, out);
+
+    RecordHeader header;
+    header.chunkBytes = static_cast<std::uint32_t>(out.size() - chunkOffset);
+    header.decorationCount = static_cast<std::uint32_t>(decorations.size());
+    std::memcpy(out.data() + headerOffset, &header, sizeof(header));
+
+    for (const BlockWrite& write : decorations)
+    {
+        put(out, StoredWrite{write.position.x, write.position.y, write.position.z, write.block, static_cast<std::uint8_t>(write.soft), 0});
+    }
+}
+
+bool ChunkCodec::decode_record(const std::uint8_t* data, std::size_t size, Chunk& chunk, std::vector<BlockWrite>& decorations)
+{
+    RecordHeader header;
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    data += sizeof(header);
+    size -= sizeof(header);
+
+    if (header.chunkBytes > size || (size - header.chunkBytes) / sizeof(StoredWrite) < header.decorationCount)
+        return false;
+    if (!decode(data, header.chunkBytes, chunk))
+        return false;
+
+    Reader reader(data + header.chunkBytes, size - header.chunkBytes);
+    decorations.clear();
+    decorations.reserve(header.decorationCount);
+    for (std::uint32_t i = 0; i < header.decorationCount; ++i)
+    {
+        StoredWrite stored;
+        reader.get(stored);
+        decorations.push_back(BlockWrite{glm::ivec3(stored.x, stored.y, stored.z), stored.block, stored.soft != 0});
+    }
+    return true;
+}
+
+} // namespace world
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "Decorator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace world
+{
+// Compact binary form of a chunk's blocks and, optionally, its light. Each section is stored
+// either as a single value (air, solid stone) or as (value, run length) pairs in section index
+// order, so typical terrain shrinks from 192 KiB to a few KiB. Values are little-endian.
+class ChunkCodec
+{
+  public:
+    // Appends the encoded chunk to out.
+    static void encode(const Chunk& chunk, bool withLight, std::vector<std::uint8_t>& out);
+
+    // Decodes into a freshly constructed chunk. Returns false if the data is truncated or
+    // malformed; the chunk contents are unspecified in that case. Stored light marks the
+    // chunk lit.
+    static bool decode(const std::uint8_t* data, std::size_t size, Chunk& chunk);
+
+    // A finished chunk as persisted: the encoded chunk followed by the decoration writes its
+    // neighbours still need to finalize next to it. decode_record ignores any bytes after the
+    // decorations, so records from older pregeneration runs that appended meshes still load.
+    static void encode_record(const Chunk& chunk, bool withLight, const std::vector<BlockWrite>& decorations, std::vector<std::uint8_t>& out);
+    static bool decode_record(const std::uint8_t* data, std::size_t size, Chunk& chunk, std::vector<BlockWrite>& decorations);
+};
+
+} // namespace world
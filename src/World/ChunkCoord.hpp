@@ -4,6 +4,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <glm/vec3.hpp>
 #include <tuple>
 
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "ChunkCoord.hpp"
+
+#include "Core/Epoch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace world
+{
+// Names one grid entry by its coordinate and the generation it was stored with. Unlike a
+// pointer it can be kept for as long as needed: once the entry leaves the grid the handle
+// simply stops resolving, even if the same coordinate is loaded again.
+struct ChunkHandle
+{
+    ChunkCoord coord;
+    std::uint32_t generation = 0; // Never 0 for a stored entry.
+
+    bool operator==(const ChunkHandle&) const = default;
+};
+
+// Sparse grid of entries, in pages of PageSize x PageSize chunks that exist only while they
+// hold an entry, so any number of separate areas can be loaded anywhere in the world at a
+// cost proportional to what is loaded. A lookup, neighbours included, is a probe of a small
+// page table plus an index computation and one atomic load: no lock and no hashing per chunk.
+//
+// The grid owns its entries and hands out plain pointers, which stay valid while the reader
+// holds an EpochGuard on the grid's domain: an entry that is replaced or erased is retired to
+// the domain rather than deleted, and so are emptied pages and superseded page tables.
+// Lookups therefore never touch a reference count.
+//
+// Only one thread (the streamer's update thread) writes; any thread may read, and the writer
+// itself needs no guard. T must provide coord() and handle(), the latter set before the entry
+// is stored.
+template <typename T> class ChunkGrid
+{
+  public:
+    static constexpr int PageShift = 4;
+    static constexpr int PageSize = 1 << PageShift;
+
+    explicit ChunkGrid(core::EpochDomain& epochs) : m_table(new PageTable()), m_epochs(epochs) {}
+
+    // No thread may be reading any more.
+    ~ChunkGrid()
+    {
+        PageTable* table = m_table.load(std::memory_order_relaxed);
+        for (Page* page : table->pages)
+        {
+            for (auto& cell : page->slots)
+            {
+                delete cell.load(std::memory_order_relaxed);
+            }
+            delete page;
+        }
+        delete table;
+    }
+
+    ChunkGrid(const ChunkGrid&) = delete;
+    ChunkGrid& operator=(const ChunkGrid&) = delete;
+
+    // The entry for coord, or null.
+    T* find(const ChunkCoord& coord) const
+    {
+        const Page* page = m_table.load(std::memory_order_acquire)->find(page_coord(coord));
+        return page ? page->slots[local_index(coord)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // The entry the handle was issued for, or null once it has left the grid.
+    T* resolve(const ChunkHandle& handle) const
+    {
+        T* entry = find(handle.coord);
+        return entry && entry->handle() == handle ? entry : nullptr;
+    }
+
+    // The handle of the next entry stored at coord.
+    ChunkHandle next_handle(const ChunkCoord& coord)
+    {
+        if (++m_generation == 0)
+            ++m_generation;
+        return {coord, m_generation};
+    }
+
+    // Takes ownership of entry and stores it at coord, retiring any previous entry there.
+    T* store(const ChunkCoord& coord, std::unique_ptr<T> entry)
+    {
+        Page* page = m_table.load(std::memory_order_relaxed)->find(page_coord(coord));
+        if (!page)
+            page = add_page(page_coord(coord));
+
+        T* stored = entry.release();
+        if (T* previous = page->slots[local_index(coord)].exchange(stored, std::memory_order_acq_rel))
+            m_epochs.retire(previous);
+        else
+            ++page->occupied;
+        return stored;
+    }
+
+    // Empties coord's slot and retires its entry, and the page with it once the page is empty.
+    void erase(const ChunkCoord& coord)
+    {
+        Page* page = m_table.load(std::memory_order_relaxed)->find(page_coord(coord));
+        if (!page)
+            return;
+        T* entry = page->slots[local_index(coord)].exchange(nullptr, std::memory_order_acq_rel);
+        if (!entry)
+            return;
+        m_epochs.retire(entry);
+        if (--page->occupied == 0)
+            remove_page(page);
+    }
+
+    // Calls fn for every entry.
+    template <typename Fn> void for_each(Fn&& fn) const
+    {
+        for (const Page* page : m_table.load(std::memory_order_acquire)->pages)
+        {
+            for (const auto& cell : page->slots)
+            {
+                if (T* entry = cell.load(std::memory_order_acquire))
+                    fn(*entry);
+            }
+        }
+    }
+
+    std::size_t page_count() const { return m_table.load(std::memory_order_acquire)->pages.size(); }
+
+  private:
+    // Lookups must not fall back to a lock inside the atomics, as std::atomic<std::shared_ptr>
+    // does in libstdc++; plain pointers with epoch reclamation are what keeps reads lock-free.
+    static_assert(std::atomic<T*>::is_always_lock_free);
+
+    struct Page
+    {
+        ChunkCoord origin; // In pages.
+        std::array<std::atomic<T*>, PageSize * PageSize> slots{};
+        // Occupied slots; writer only.
+        int occupied = 0;
+    };
+
+    // Immutable once published: the writer builds a new table for every page added or removed,
+    // which happens once per PageSize chunks an area moves, and retires the old one.
+    struct PageTable
+    {
+        std::vector<Page*> pages;
+        // Open addressing with linear probing, at most half full; null marks the end of a run.
+        std::vector<Page*> buckets;
+
+        Page* find(const ChunkCoord& origin) const
+        {
+            if (buckets.empty())
+                return nullptr;
+            const std::size_t mask = buckets.size() - 1;
+            for (std::size_t index = std::hash<ChunkCoord>{}(origin) & mask;; index = (index + 1) & mask)
+            {
+                Page* page = buckets[index];
+                if (!page || page->origin == origin)
+                    return page;
+            }
+        }
+    };
+
+    static ChunkCoord page_coord(const ChunkCoord& coord) { return {coord.x >> PageShift, coord.z >> PageShift}; }
+    static std::size_t local_index(const ChunkCoord& coord)
+    {
+        return static_cast<std::size_t>((coord.x & (PageSize - 1)) + (coord.z & (PageSize - 1)) * PageSize);
+    }
+
+    Page* add_page(const ChunkCoord& origin)
+    {
+        auto* page = new Page();
+        page->origin = origin;
+        std::vector<Page*> pages = m_table.load(std::memory_order_relaxed)->pages;
+        pages.push_back(page);
+        publish(std::move(pages));
+        return page;
+    }
+
+    void remove_page(Page* page)
+    {
+        std::vector<Page*> pages = m_table.load(std::memory_order_relaxed)->pages;
+        pages.erase(std::find(pages.begin(), pages.end(), page));
+        publish(std::move(pages));
+        m_epochs.retire(page);
+    }
+
+    void publish(std::vector<Page*> pages)
+    {
+        auto table = std::make_unique<PageTable>();
+        std::size_t bucketCount = 16;
+        while (bucketCount < pages.size() * 2)
+        {
+            bucketCount *= 2;
+        }
+        table->buckets.assign(bucketCount, nullptr);
+        const std::size_t mask = bucketCount - 1;
+        for (Page* page : pages)
+        {
+            std::size_t index = std::hash<ChunkCoord>{}(page->origin) & mask;
+            while (table->buckets[index])
+            {
+                index = (index + 1) & mask;
+            }
+            table->buckets[index] = page;
+        }
+        table->pages = std::move(pages);
+        m_epochs.retire(m_table.exchange(table.release(), std::memory_order_acq_rel));
+    }
+
+    static_assert(std::atomic<PageTable*>::is_always_lock_free);
+    std::atomic<PageTable*> m_table;
+    // Source of handle generations; writer only.
+    std::uint32_t m_generation = 0;
+    core::EpochDomain& m_epochs;
+};
+
+} // namespace world
@@ -1,51 +1,182 @@
 #include "ChunkMesh.hpp"
 
+#include <bit>
+
 namespace world
 {
+namespace
+{
+// The parts are laid out in MeshPart order, so everything from the first changed part on is
+// sent again and the parts before it stay in place.
+std::size_t upload_parts(renderer::GpuMesh& mesh, const MeshParts& cpu, std::uint8_t parts, bool dynamic)
+{
+    std::array<renderer::GpuMesh::Part, MeshPartCount> views;
+    for (std::size_t index = 0; index < views.size(); ++index)
+    {
+        views[index] = {cpu[index].vertices, cpu[index].indices};
+    }
+    return mesh.upload_parts(views, static_cast<std::size_t>(std::countr_zero(parts)), dynamic);
+}
+
+// Frees the parts' memory, not just their contents. Returns the bytes freed.
+std::size_t free_parts(MeshParts& parts)
+{
+    const std::size_t bytes = parts_bytes(parts);
+    parts = MeshParts{};
+    return bytes;
+}
+} // namespace
+
+void append_buffers(MeshBuffers& dst, const MeshBuffers& src)
+{
+    const auto base = static_cast<std::uint32_t>(dst.vertices.size());
+    dst.vertices.insert(dst.vertices.end(), src.vertices.begin(), src.vertices.end());
+    for (const std::uint32_t index : src.indices)
+    {
+        dst.indices.push_back(base + index);
+    }
+}
+
+std::size_t buffer_bytes(const MeshBuffers& buffers)
+{
+    return buffers.vertices.capacity() * sizeof(renderer::ChunkVertex) + buffers.indices.capacity() * sizeof(std::uint32_t);
+}
+
+std::size_t parts_bytes(const MeshParts& parts)
+{
+    std::size_t bytes = 0;
+    for (const MeshBuffers& buffers : parts)
+    {
+        bytes += buffer_bytes(buffers);
+    }
+    return bytes;
+}
+
 ChunkMesh::ChunkMesh() = default;
+ChunkMesh::~ChunkMesh() = default;
+
+void ChunkMesh::mark_changed(std::uint8_t lod, std::uint8_t parts)
+{
+    m_changed[lod] |= parts;
+    if (parts == AllMeshParts)
+    {
+        const auto bit = static_cast<std::uint8_t>(1u << lod);
+        m_cpuMissing.fetch_and(static_cast<std::uint8_t>(~bit), std::memory_order_relaxed);
+        m_evicted &= static_cast<std::uint8_t>(~bit);
+    }
+}
 
-void ChunkMesh::upload(std::uint8_t lod)
+std::size_t ChunkMesh::upload(renderer::MeshFactory& factory)
 {
-    auto& cpuOpaque = m_cpuOpaque[lod];
-    auto& cpuTransparent = m_cpuTransparent[lod];
+    std::size_t sent = 0;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        sent += upload(factory, lod);
+    }
+    return sent;
+}
+
+std::size_t ChunkMesh::upload(renderer::MeshFactory& factory, std::uint8_t lod)
+{
+    const std::uint8_t parts = m_changed[lod];
+    if (parts == 0)
+        return 0;
     auto& gpu = m_gpuMeshes[lod];
+    if (!gpu.opaque)
+    {
+        gpu.opaque = factory.create_mesh();
+        gpu.transparent = factory.create_mesh();
+    }
+    m_changed[lod] = 0;
+    return upload_parts(*gpu.opaque, m_cpuOpaque[lod], parts, false) + upload_parts(*gpu.transparent, m_cpuTransparent[lod], parts, true);
+}
 
-    if (!cpuOpaque.vertices.empty() && !cpuOpaque.indices.empty())
+std::size_t ChunkMesh::cpu_bytes() const
+{
+    std::size_t bytes = 0;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
     {
-        gpu.opaque.upload(cpuOpaque.vertices, cpuOpaque.indices);
-        gpu.hasOpaque = true;
+        bytes += parts_bytes(m_cpuOpaque[lod]) + parts_bytes(m_cpuTransparent[lod]);
     }
-    else
+    return bytes;
+}
+
+std::size_t ChunkMesh::gpu_vertex_bytes() const
+{
+    std::size_t bytes = 0;
+    for (const LodMesh& mesh : m_gpuMeshes)
     {
-        gpu.hasOpaque = false;
+        if (mesh.opaque)
+            bytes += mesh.opaque->vertex_bytes() + mesh.transparent->vertex_bytes();
     }
+    return bytes;
+}
 
-    if (!cpuTransparent.vertices.empty() && !cpuTransparent.indices.empty())
+std::size_t ChunkMesh::gpu_index_bytes() const
+{
+    std::size_t bytes = 0;
+    for (const LodMesh& mesh : m_gpuMeshes)
     {
-        gpu.transparent.upload(cpuTransparent.vertices, cpuTransparent.indices, true);
-        gpu.hasTransparent = true;
+        if (mesh.opaque)
+            bytes += mesh.opaque->index_bytes() + mesh.transparent->index_bytes();
     }
-    else
+    return bytes;
+}
+
+std::size_t ChunkMesh::shrink_gpu()
+{
+    std::size_t freed = 0;
+    for (LodMesh& mesh : m_gpuMeshes)
+    {
+        if (mesh.opaque)
+            freed += mesh.opaque->shrink_to_fit() + mesh.transparent->shrink_to_fit();
+    }
+    return freed;
+}
+
+std::size_t ChunkMesh::drop_cpu()
+{
+    std::size_t freed = 0;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        if (!m_gpuMeshes[lod].opaque || m_changed[lod] != 0)
+            continue;
+        freed += free_parts(m_cpuOpaque[lod]) + free_parts(m_cpuTransparent[lod]);
+        m_cpuMissing.fetch_or(static_cast<std::uint8_t>(1u << lod), std::memory_order_relaxed);
+    }
+    return freed;
+}
+
+std::size_t ChunkMesh::evict_lod(std::uint8_t lod)
+{
+    LodMesh& mesh = m_gpuMeshes[lod];
+    std::size_t freed = free_parts(m_cpuOpaque[lod]) + free_parts(m_cpuTransparent[lod]);
+    if (mesh.opaque)
     {
-        gpu.hasTransparent = false;
+        freed += mesh.opaque->vertex_bytes() + mesh.opaque->index_bytes() + mesh.transparent->vertex_bytes() + mesh.transparent->index_bytes();
+        mesh = LodMesh{};
     }
+    m_changed[lod] = 0;
+    m_cpuMissing.fetch_or(static_cast<std::uint8_t>(1u << lod), std::memory_order_relaxed);
+    m_evicted |= static_cast<std::uint8_t>(1u << lod);
+    return freed;
 }
 
 void ChunkMesh::draw_opaque(std::uint8_t lod) const
 {
     const auto& mesh = m_gpuMeshes[lod];
-    if (mesh.hasOpaque)
+    if (mesh.opaque && !mesh.opaque->empty())
     {
-        mesh.opaque.draw();
+        mesh.opaque->draw();
     }
 }
 
 void ChunkMesh::draw_transparent(std::uint8_t lod) const
 {
     const auto& mesh = m_gpuMeshes[lod];
-    if (mesh.hasTransparent)
+    if (mesh.transparent && !mesh.transparent->empty())
     {
-        mesh.transparent.draw();
+        mesh.transparent->draw();
     }
 }
 
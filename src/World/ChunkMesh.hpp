@@ -1,9 +1,13 @@
 #pragma once
 
 #include "Chunk.hpp"
-#include "Renderer/Mesh.hpp"
+#include "Renderer/GpuMesh.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace world
@@ -14,30 +18,95 @@ struct MeshBuffers
     std::vector<std::uint32_t> indices;
 };
 
-struct LodMesh
+// Appends src to dst, rebasing src's indices onto the vertices already in dst.
+void append_buffers(MeshBuffers& dst, const MeshBuffers& src);
+// Memory the buffers hold, by capacity.
+std::size_t buffer_bytes(const MeshBuffers& buffers);
+
+// A chunk mesh is built and uploaded in parts. The interior holds every face that depends on
+// the chunk alone; each border strip holds the faces on one vertical border plane, which also
+// depend on the neighbour across it. When only a neighbour changes, just the strip facing it
+// is rebuilt and sent again, while the interior stays where it is on the GPU.
+enum class MeshPart : std::uint8_t
 {
-    renderer::Mesh opaque;
-    renderer::Mesh transparent;
-    bool hasOpaque = false;
-    bool hasTransparent = false;
+    Interior,
+    PosX,
+    NegX,
+    PosZ,
+    NegZ
 };
 
+constexpr int MeshPartCount = 5;
+constexpr std::uint8_t AllMeshParts = (1u << MeshPartCount) - 1;
+
+constexpr std::uint8_t part_bit(MeshPart part)
+{
+    return static_cast<std::uint8_t>(1u << static_cast<int>(part));
+}
+
+// One pass of one LOD, indexed by MeshPart; each part's indices are relative to its own vertices.
+using MeshParts = std::array<MeshBuffers, MeshPartCount>;
+
+std::size_t parts_bytes(const MeshParts& parts);
+
+// The CPU side of a chunk mesh is what the streamer builds and keeps; the GPU side is created
+// through a MeshFactory by the first upload, so a chunk that is never drawn, or a streamer
+// running without one, owns no GPU objects.
+//
+// Under memory pressure either side of a LOD can be given up (see MemoryBudget): a LOD whose
+// CPU copy was dropped still draws, an evicted one does not. Patching border strips needs the
+// CPU copy of the whole mesh, so while anything is missing only a full rebuild is accepted,
+// and that rebuild restores every LOD.
 class ChunkMesh
 {
   public:
     ChunkMesh();
+    ~ChunkMesh();
 
-    MeshBuffers& cpu_opaque(std::uint8_t lod) { return m_cpuOpaque[lod]; }
-    MeshBuffers& cpu_transparent(std::uint8_t lod) { return m_cpuTransparent[lod]; }
+    MeshParts& cpu_opaque(std::uint8_t lod) { return m_cpuOpaque[lod]; }
+    MeshParts& cpu_transparent(std::uint8_t lod) { return m_cpuTransparent[lod]; }
 
-    void upload(std::uint8_t lod);
+    // Records that the CPU parts of one LOD named by `parts` (part_bit mask) changed since the
+    // GPU copy was last brought up to date.
+    void mark_changed(std::uint8_t lod, std::uint8_t parts);
+    bool gpu_current(std::uint8_t lod) const { return m_changed[lod] == 0; }
+
+    // False once a CPU copy was dropped or a LOD evicted. Read by mesh jobs on any thread.
+    bool complete() const { return m_cpuMissing.load(std::memory_order_relaxed) == 0; }
+    bool has_lod(std::uint8_t lod) const { return !(m_evicted & (1u << lod)); }
+
+    // Memory held, by capacity; see MemoryBudget.
+    std::size_t cpu_bytes() const;
+    std::size_t gpu_vertex_bytes() const;
+    std::size_t gpu_index_bytes() const;
+
+    // Each returns the number of bytes freed. drop_cpu frees the CPU copy of every LOD that is
+    // current on the GPU; evict_lod frees both copies of one LOD.
+    std::size_t shrink_gpu();
+    std::size_t drop_cpu();
+    std::size_t evict_lod(std::uint8_t lod);
+
+    // Sends every changed part of every LOD, or of one, to the GPU, creating the GPU meshes on
+    // first use. Returns the number of bytes sent.
+    std::size_t upload(renderer::MeshFactory& factory);
+    std::size_t upload(renderer::MeshFactory& factory, std::uint8_t lod);
     void draw_opaque(std::uint8_t lod) const;
     void draw_transparent(std::uint8_t lod) const;
 
   private:
-    std::array<MeshBuffers, 3> m_cpuOpaque;
-    std::array<MeshBuffers, 3> m_cpuTransparent;
+    struct LodMesh
+    {
+        std::unique_ptr<renderer::GpuMesh> opaque;
+        std::unique_ptr<renderer::GpuMesh> transparent;
+    };
+
+    std::array<MeshParts, 3> m_cpuOpaque;
+    std::array<MeshParts, 3> m_cpuTransparent;
+    std::array<std::uint8_t, 3> m_changed{};
     std::array<LodMesh, 3> m_gpuMeshes;
+    // One bit per LOD.
+    std::atomic<std::uint8_t> m_cpuMissing{0};
+    std::uint8_t m_evicted = 0;
 };
 
 } // namespace world
@@ -1,5 +1,7 @@
 #include "ChunkSection.hpp"
 
+#include "Core/Simd.hpp"
+
 #include <algorithm>
 #include <cassert>
 
@@ -7,7 +9,38 @@ namespace world
 {
 ChunkSection::ChunkSection()
 {
-    m_blocks.fill(BlockAir);
+    m_uniformBlocks.fill(BlockAir);
+    m_uniformLight.fill(static_cast<std::uint8_t>(MaxLightLevel << 4));
+}
+
+ChunkSection::~ChunkSection()
+{
+    delete m_storage.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+T ChunkSection::load_cell(const T& cell)
+{
+    return std::atomic_ref(const_cast<T&>(cell)).load(std::memory_order_relaxed);
+}
+
+// Published with release so a reader that sees the pointer also sees the copied values. An
+// edit on the main thread and a light job can both find the section uniform; the first to
+// publish wins and the other drops its copy and writes into the winner's.
+ChunkSection::Storage& ChunkSection::storage()
+{
+    Storage* existing = m_storage.load(std::memory_order_acquire);
+    if (existing)
+        return *existing;
+
+    auto* created = new Storage();
+    core::simd::fill_u16(created->blocks.data(), created->blocks.size(), m_uniformBlocks[0]);
+    created->light.fill(m_uniformLight[0]);
+    if (m_storage.compare_exchange_strong(existing, created, std::memory_order_acq_rel, std::memory_order_acquire))
+        return *created;
+
+    delete created;
+    return *existing;
 }
 
 BlockID ChunkSection::get(int x, int y, int z) const
@@ -15,7 +48,10 @@ BlockID ChunkSection::get(int x, int y, int z) const
     assert(x >= 0 && x < SectionSize);
     assert(y >= 0 && y < SectionSize);
     assert(z >= 0 && z < SectionSize);
-    return m_blocks[index(x, y, z)];
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    if (!cells)
+        return m_uniformBlocks[0];
+    return load_cell(cells->blocks[static_cast<std::size_t>(index(x, y, z))]);
 }
 
 void ChunkSection::set(int x, int y, int z, BlockID id)
@@ -23,11 +59,134 @@ void ChunkSection::set(int x, int y, int z, BlockID id)
     assert(x >= 0 && x < SectionSize);
     assert(y >= 0 && y < SectionSize);
     assert(z >= 0 && z < SectionSize);
-    m_blocks[index(x, y, z)] = id;
+    if (!allocated() && id == m_uniformBlocks[0])
+        return;
+
+    // Only the main thread writes blocks once a chunk has generated, so the plain scan below
+    // reads nothing that changes under it.
+    auto& blocks = storage().blocks;
+    BlockID& slot = blocks[static_cast<std::size_t>(index(x, y, z))];
+    const BlockID previous = load_cell(slot);
+    std::atomic_ref(slot).store(id, std::memory_order_relaxed);
     if (id != BlockAir)
     {
-        m_isEmpty = false;
+        m_isEmpty.store(false, std::memory_order_relaxed);
+    }
+    else if (previous != BlockAir)
+    {
+        // Removing a block may have emptied the section; a SIMD scan of 4096 IDs is cheap
+        // next to the remesh the edit triggers anyway.
+        m_isEmpty.store(core::simd::all_equal_u16(blocks.data(), blocks.size(), BlockAir), std::memory_order_relaxed);
+    }
+}
+
+void ChunkSection::fill(BlockID id)
+{
+    if (Storage* cells = m_storage.load(std::memory_order_acquire))
+        core::simd::fill_u16(cells->blocks.data(), cells->blocks.size(), id);
+    else
+        m_uniformBlocks.fill(id);
+    m_isEmpty.store(id == BlockAir, std::memory_order_relaxed);
+}
+
+void ChunkSection::set_layer(int y, const BlockID* blocks)
+{
+    assert(y >= 0 && y < SectionSize);
+    if (!allocated() && core::simd::all_equal_u16(blocks, SectionLayerArea, m_uniformBlocks[0]))
+        return;
+
+    core::simd::copy_u16(storage().blocks.data() + index(0, y, 0), blocks, SectionLayerArea);
+    if (empty() && !core::simd::all_equal_u16(blocks, SectionLayerArea, BlockAir))
+    {
+        m_isEmpty.store(false, std::memory_order_relaxed);
+    }
+}
+
+void ChunkSection::copy_layer(int y, BlockID* out) const
+{
+    assert(y >= 0 && y < SectionSize);
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    if (!cells)
+    {
+        std::copy(m_uniformBlocks.begin(), m_uniformBlocks.end(), out);
+        return;
+    }
+    const BlockID* layer = cells->blocks.data() + index(0, y, 0);
+    for (int cell = 0; cell < SectionLayerArea; ++cell)
+    {
+        out[cell] = load_cell(layer[cell]);
+    }
+}
+
+std::uint8_t ChunkSection::light(int x, int y, int z) const
+{
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    if (!cells)
+        return m_uniformLight[0];
+    return load_cell(cells->light[static_cast<std::size_t>(index(x, y, z))]);
+}
+
+void ChunkSection::set_light(int x, int y, int z, std::uint8_t packed)
+{
+    if (!allocated() && packed == m_uniformLight[0])
+        return;
+    std::atomic_ref(storage().light[static_cast<std::size_t>(index(x, y, z))]).store(packed, std::memory_order_relaxed);
+}
+
+void ChunkSection::copy_light_layer(int y, std::uint8_t* out) const
+{
+    assert(y >= 0 && y < SectionSize);
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    if (!cells)
+    {
+        std::copy(m_uniformLight.begin(), m_uniformLight.end(), out);
+        return;
+    }
+    const std::uint8_t* layer = cells->light.data() + index(0, y, 0);
+    for (int cell = 0; cell < SectionLayerArea; ++cell)
+    {
+        out[cell] = load_cell(layer[cell]);
+    }
+}
+
+void ChunkSection::set_light_layer(int y, const std::uint8_t* packed)
+{
+    assert(y >= 0 && y < SectionSize);
+    if (!allocated() && std::all_of(packed, packed + SectionLayerArea, [&](std::uint8_t value) { return value == m_uniformLight[0]; }))
+        return;
+    std::copy(packed, packed + SectionLayerArea, storage().light.begin() + index(0, y, 0));
+}
+
+void ChunkSection::fill_light(std::uint8_t packed)
+{
+    if (Storage* cells = m_storage.load(std::memory_order_acquire))
+        cells->light.fill(packed);
+    else
+        m_uniformLight.fill(packed);
+}
+
+const BlockID* ChunkSection::blocks() const
+{
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    return cells ? cells->blocks.data() : nullptr;
+}
+
+const std::uint8_t* ChunkSection::light_values() const
+{
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    return cells ? cells->light.data() : nullptr;
+}
+
+bool ChunkSection::uniform(BlockID& value) const
+{
+    const Storage* cells = m_storage.load(std::memory_order_acquire);
+    if (!cells)
+    {
+        value = m_uniformBlocks[0];
+        return true;
     }
+    value = cells->blocks[0];
+    return core::simd::all_equal_u16(cells->blocks.data(), cells->blocks.size(), value);
 }
 
 int ChunkSection::index(int x, int y, int z)
@@ -3,28 +3,82 @@
 #include "Block.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
 namespace world
 {
 constexpr int SectionSize = 16;
 constexpr int SectionVolume = SectionSize * SectionSize * SectionSize;
+constexpr int SectionLayerArea = SectionSize * SectionSize;
 
+// A section of a single block with a single light value throughout, like the open air above
+// the terrain or the solid stone below it, stores just one layer of each. The full per-cell
+// arrays are allocated by the first write that breaks the uniformity and kept from then on,
+// so a reader on another thread never loses the storage it is looking at.
+//
+// Cells are edited on the main thread and relit under LightEngine's mutex while mesh and light
+// workers read them, so every per-cell access is a relaxed atomic one. Readers may see a
+// neighbouring edit half applied; the remesh that edit schedules corrects it.
 class ChunkSection
 {
   public:
+    // Per-cell storage of a section that is not uniform.
+    static constexpr std::size_t StorageBytes = SectionVolume * (sizeof(BlockID) + sizeof(std::uint8_t));
+
     ChunkSection();
+    ~ChunkSection();
+
+    ChunkSection(const ChunkSection&) = delete;
+    ChunkSection& operator=(const ChunkSection&) = delete;
 
     BlockID get(int x, int y, int z) const;
     void set(int x, int y, int z, BlockID id);
 
-    bool empty() const { return m_isEmpty; }
+    // Bulk writes go through the SIMD kernels in Core/Simd.hpp and are only used while the
+    // chunk is generating. A layer is the 16x16 plane at local height y, laid out x-fastest.
+    void fill(BlockID id);
+    void set_layer(int y, const BlockID* blocks);
+    void copy_layer(int y, BlockID* out) const;
+
+    bool empty() const { return m_isEmpty.load(std::memory_order_relaxed); }
+    bool uniform(BlockID& value) const;
+    bool allocated() const { return m_storage.load(std::memory_order_acquire) != nullptr; }
+
+    // Packed light per cell: sky light in the high nibble, block light in the low nibble.
+    // Sections start fully sky-lit; LightEngine darkens whatever lies below the surface.
+    std::uint8_t light(int x, int y, int z) const;
+    void set_light(int x, int y, int z, std::uint8_t packed);
+    void copy_light_layer(int y, std::uint8_t* out) const;
+    void set_light_layer(int y, const std::uint8_t* packed);
+    void fill_light(std::uint8_t packed);
+
+    // The whole section's values, x fastest then z then y; null while it is uniform. Only for
+    // chunks nothing edits any more, like those being saved after an unload.
+    const BlockID* blocks() const;
+    const std::uint8_t* light_values() const;
 
-  private:
     static int index(int x, int y, int z);
 
-    std::array<BlockID, SectionVolume> m_blocks{};
-    bool m_isEmpty = true;
+  private:
+    struct Storage
+    {
+        std::array<BlockID, SectionVolume> blocks;
+        std::array<std::uint8_t, SectionVolume> light;
+    };
+
+    Storage& storage();
+
+    // Relaxed atomic load of a cell; std::atomic_ref wants a non-const object even to load.
+    template <typename T>
+    static T load_cell(const T& cell);
+
+    std::atomic<Storage*> m_storage{nullptr};
+    // The uniform block and light as whole layers, for copy_layer() and copy_light_layer().
+    std::array<BlockID, SectionLayerArea> m_uniformBlocks{};
+    std::array<std::uint8_t, SectionLayerArea> m_uniformLight{};
+    std::atomic_bool m_isEmpty{true};
 };
 
 } // namespace world
@@ -0,0 +1,123 @@
+#include "Decorator.hpp"
+
+#include "Util/Hash.hpp"
+#include "Util/Math.hpp"
+
+#include <array>
+#include <cstdlib>
+
+namespace world
+{
+namespace
+{
+constexpr BlockID GrassBlock = 1;
+constexpr BlockID LogBlock = 8;
+constexpr BlockID LeavesBlock = 9;
+
+// Trees per 1000 columns.
+int tree_density(Biome biome)
+{
+    switch (biome)
+    {
+    case Biome::Forest: return 30;
+    case Biome::Plains: return 3;
+    default: return 0;
+    }
+}
+
+std::uint64_t column_hash(int seed, int x, int z)
+{
+    std::uint64_t value = static_cast<std::uint32_t>(seed);
+    value = util::mix64(value ^ (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32));
+    return util::mix64(value ^ static_cast<std::uint32_t>(z));
+}
+
+void add_tree(const glm::ivec3& base, int trunkHeight, std::uint64_t random, std::vector<BlockWrite>& writes)
+{
+    const int top = base.y + trunkHeight;
+
+    // Two wide layers below the top, then a narrow cap; corners are trimmed at random and
+    // always on the topmost layer.
+    int bit = 0;
+    for (int y = top - 2; y <= top + 1; ++y)
+    {
+        const int radius = y < top ? Decorator::MaxReach : 1;
+        for (int dz = -radius; dz <= radius; ++dz)
+        {
+            for (int dx = -radius; dx <= radius; ++dx)
+            {
+                const bool corner = std::abs(dx) == radius && std::abs(dz) == radius;
+                if (corner && (y == top + 1 || ((random >> (bit++ % 40)) & 1u)))
+                    continue;
+                writes.push_back({{base.x + dx, y, base.z + dz}, LeavesBlock, true});
+            }
+        }
+    }
+
+    for (int y = base.y; y < top; ++y)
+    {
+        writes.push_back({{base.x, y, base.z}, LogBlock, false});
+    }
+}
+} // namespace
+
+void Decorator::decorate(const Chunk& chunk, const WorldGenerator& generator, std::vector<BlockWrite>& writes)
+{
+    const ChunkCoord coord = chunk.coord();
+    const int originX = coord.x * ChunkWidth;
+    const int originZ = coord.z * ChunkDepth;
+    const int seed = generator.config().seed;
+
+    std::array<ClimateSample, SectionLayerArea> climate{};
+    generator.climate(originX, originZ, ChunkWidth, ChunkDepth, climate.data());
+
+    const int contentHeight = chunk.content_height();
+    for (int z = 0; z < ChunkDepth; ++z)
+    {
+        for (int x = 0; x < ChunkWidth; ++x)
+        {
+            const int density = tree_density(climate[static_cast<std::size_t>(x + z * ChunkWidth)].biome);
+            if (density == 0)
+                continue;
+
+            const std::uint64_t random = column_hash(seed, originX + x, originZ + z);
+            if (static_cast<int>(random % 1000) >= density)
+                continue;
+
+            int surface = contentHeight - 1;
+            while (surface >= 0 && chunk.get(x, surface, z) == BlockAir)
+            {
+                --surface;
+            }
+            if (surface < 0 || chunk.get(x, surface, z) != GrassBlock)
+                continue;
+
+            const int trunkHeight = 4 + static_cast<int>((random >> 16) % 3);
+            if (surface + trunkHeight + 2 >= ChunkHeight)
+                continue;
+
+            add_tree({originX + x, surface + 1, originZ + z}, trunkHeight, random >> 24, writes);
+        }
+    }
+}
+
+void Decorator::apply(Chunk& chunk, const std::vector<BlockWrite>& writes)
+{
+    const ChunkCoord coord = chunk.coord();
+    for (const BlockWrite& write : writes)
+    {
+        if (util::floor_div(write.position.x, ChunkWidth) != coord.x || util::floor_div(write.position.z, ChunkDepth) != coord.z)
+            continue;
+
+        const int x = write.position.x - coord.x * ChunkWidth;
+        const int z = write.position.z - coord.z * ChunkDepth;
+        const BlockID current = chunk.get(x, write.position.y, z);
+        const bool replaceable = current == BlockAir || (!write.soft && current == LeavesBlock);
+        if (replaceable)
+        {
+            chunk.set(x, write.position.y, z, write.block);
+        }
+    }
+}
+
+} // namespace world
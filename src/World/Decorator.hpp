@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "WorldGen.hpp"
+
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace world
+{
+struct BlockWrite
+{
+    glm::ivec3 position{0}; // world space
+    BlockID block = BlockAir;
+    // Soft writes (leaves) only fill air; hard writes (logs) also replace soft blocks.
+    bool soft = false;
+};
+
+// Places features such as trees on top of generated terrain. Features are rooted in the
+// decorated chunk but may reach into its eight neighbours, so decoration does not write blocks
+// directly: it returns world-space writes, and every chunk later applies the writes from
+// itself and its neighbours that fall inside it. The writes are a pure function of the seed
+// and the chunk's own terrain, and apply() gives the same result in any order.
+class Decorator
+{
+  public:
+    static void decorate(const Chunk& chunk, const WorldGenerator& generator, std::vector<BlockWrite>& writes);
+    static void apply(Chunk& chunk, const std::vector<BlockWrite>& writes);
+
+    // Furthest a feature reaches past the column it is rooted in.
+    static constexpr int MaxReach = 2;
+};
+
+} // namespace world
@@ -0,0 +1,300 @@
+#include "FarTerrain.hpp"
+
+#include "AtlasUV.hpp"
+#include "BlockRegistry.hpp"
+#include "Chunk.hpp"
+#include "StreamingView.hpp"
+
+#include "Config.hpp"
+#include "Util/Math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace world
+{
+namespace
+{
+constexpr int VerticesPerSide = FarTerrain::TileCells + 1;
+// Samples include a one-sample border so normals on tile edges match the neighbour.
+constexpr int SamplesPerSide = VerticesPerSide + 2;
+// Far terrain is always fully sky-lit.
+constexpr std::uint8_t FullLight = 255;
+
+std::uint8_t face_layer(BlockID block, BlockFace face)
+{
+    return tile_layer(registry().definition(block).faces[static_cast<int>(face)]);
+}
+
+renderer::ChunkVertex make_vertex(const glm::vec3& position, std::uint32_t normal, const glm::vec2& uv, std::uint8_t layer)
+{
+    renderer::ChunkVertex vertex{};
+    vertex.position[0] = position.x;
+    vertex.position[1] = position.y;
+    vertex.position[2] = position.z;
+    vertex.normalPacked = normal;
+    vertex.uv[0] = uv.x;
+    vertex.uv[1] = uv.y;
+    vertex.light = FullLight;
+    vertex.layer = layer;
+    return vertex;
+}
+} // namespace
+
+// One worker is plenty: tiles only scroll in when the camera crosses a tile-pair boundary of
+// their level, and the voxel chunks need the remaining cores more.
+FarTerrain::FarTerrain(const WorldGenerator& generator, renderer::MeshFactory* meshes)
+    : m_generator(generator)
+    , m_meshes(meshes)
+    , m_enabled(config::far_terrain().enabled && meshes != nullptr)
+    , m_levels(std::max(config::far_terrain().levels, 1))
+    , m_baseSpacing(std::max(config::far_terrain().baseSpacing, 1))
+    , m_jobs(2)
+{
+}
+
+void FarTerrain::update(const glm::vec3& cameraPosition, const ChunkCoord& voxelCenter, int voxelRadius)
+{
+    if (!m_enabled)
+        return;
+
+    process_built();
+
+    const int cameraX = static_cast<int>(std::floor(cameraPosition.x));
+    const int cameraZ = static_cast<int>(std::floor(cameraPosition.z));
+    std::vector<glm::ivec2> anchors(static_cast<std::size_t>(m_levels));
+    for (int level = 0; level < m_levels; ++level)
+    {
+        // Snapping to pairs of tiles keeps the camera at least two tiles from either edge.
+        const int pair = 2 * tile_size(level);
+        anchors[static_cast<std::size_t>(level)] = {2 * (util::floor_div(cameraX, pair) - 2), 2 * (util::floor_div(cameraZ, pair) - 2)};
+    }
+    if (anchors == m_anchors && voxelCenter == m_voxelCenter && voxelRadius == m_voxelRadius)
+        return;
+
+    m_anchors = std::move(anchors);
+    m_voxelCenter = voxelCenter;
+    m_voxelRadius = voxelRadius;
+
+    m_wanted.clear();
+    for (int level = 0; level < m_levels; ++level)
+    {
+        const glm::ivec2 anchor = m_anchors[static_cast<std::size_t>(level)];
+        const int size = tile_size(level);
+        for (int z = anchor.y; z < anchor.y + GridTiles; ++z)
+        {
+            for (int x = anchor.x; x < anchor.x + GridTiles; ++x)
+            {
+                if (level == 0)
+                {
+                    // The disc is convex, so it covers the tile if it holds the tile's four
+                    // corner chunks.
+                    const int minX = util::floor_div(x * size, ChunkWidth);
+                    const int maxX = util::floor_div((x + 1) * size - 1, ChunkWidth);
+                    const int minZ = util::floor_div(z * size, ChunkDepth);
+                    const int maxZ = util::floor_div((z + 1) * size - 1, ChunkDepth);
+                    const bool insideVoxels = StreamingView::in_disc({minX, minZ}, voxelCenter, voxelRadius) &&
+                                              StreamingView::in_disc({maxX, minZ}, voxelCenter, voxelRadius) &&
+                                              StreamingView::in_disc({minX, maxZ}, voxelCenter, voxelRadius) &&
+                                              StreamingView::in_disc({maxX, maxZ}, voxelCenter, voxelRadius);
+                    if (insideVoxels)
+                        continue;
+                }
+                else
+                {
+                    // The finer level covers half as many of this level's tiles.
+                    const glm::ivec2 hole = m_anchors[static_cast<std::size_t>(level - 1)] / 2;
+                    if (x >= hole.x && x < hole.x + GridTiles / 2 && z >= hole.y && z < hole.y + GridTiles / 2)
+                        continue;
+                }
+                m_wanted.insert({level, x, z});
+            }
+        }
+    }
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end();)
+    {
+        it = m_wanted.contains(it->first) ? std::next(it) : m_tiles.erase(it);
+    }
+
+    std::vector<FarTileKey> missing;
+    for (const FarTileKey& key : m_wanted)
+    {
+        if (!m_tiles.contains(key) && !m_inFlight.contains(key))
+            missing.push_back(key);
+    }
+
+    // Finest levels first, nearest tiles first within a level.
+    const auto distance = [&](const FarTileKey& key) {
+        const float size = static_cast<float>(tile_size(key.level));
+        const float dx = (static_cast<float>(key.x) + 0.5f) * size - cameraPosition.x;
+        const float dz = (static_cast<float>(key.z) + 0.5f) * size - cameraPosition.z;
+        return dx * dx + dz * dz;
+    };
+    std::sort(missing.begin(), missing.end(), [&](const FarTileKey& a, const FarTileKey& b) {
+        if (a.level != b.level)
+            return a.level < b.level;
+        return distance(a) < distance(b);
+    });
+
+    for (const FarTileKey& key : missing)
+    {
+        m_inFlight.insert(key);
+        m_jobs.enqueue([this, key]() {
+            BuiltTile tile;
+            tile.key = key;
+            build_tile(tile);
+            std::lock_guard lock(m_builtMutex);
+            m_built.push_back(std::move(tile));
+        });
+    }
+}
+
+// Tiles that left their level while building are dropped here rather than cancelled.
+void FarTerrain::process_built()
+{
+    std::vector<BuiltTile> built;
+    {
+        std::lock_guard lock(m_builtMutex);
+        built.swap(m_built);
+    }
+
+    for (BuiltTile& tile : built)
+    {
+        m_inFlight.erase(tile.key);
+        if (!m_wanted.contains(tile.key))
+            continue;
+
+        const float size = static_cast<float>(tile_size(tile.key.level));
+        Tile& target = m_tiles[tile.key];
+        target.origin = glm::vec3(static_cast<float>(tile.key.x) * size, 0.0f, static_cast<float>(tile.key.z) * size);
+        target.boundsMin = glm::vec3(target.origin.x, tile.minY, target.origin.z);
+        target.boundsMax = glm::vec3(target.origin.x + size, tile.maxY, target.origin.z + size);
+        if (!target.mesh)
+            target.mesh = m_meshes->create_mesh();
+        target.mesh->upload(tile.buffers.vertices, tile.buffers.indices);
+    }
+}
+
+void FarTerrain::build_tile(BuiltTile& tile) const
+{
+    const int spacing = m_baseSpacing << tile.key.level;
+    const int originX = tile.key.x * TileCells * spacing;
+    const int originZ = tile.key.z * TileCells * spacing;
+
+    std::vector<SurfaceSample> samples(static_cast<std::size_t>(SamplesPerSide * SamplesPerSide));
+    m_generator.surface_map(originX - spacing, originZ - spacing, SamplesPerSide, SamplesPerSide, samples.data(), spacing);
+    const auto sample = [&](int i, int j) -> const SurfaceSample& {
+        return samples[static_cast<std::size_t>((i + 1) + (j + 1) * SamplesPerSide)];
+    };
+
+    auto& vertices = tile.buffers.vertices;
+    auto& indices = tile.buffers.indices;
+    vertices.reserve(static_cast<std::size_t>(VerticesPerSide * VerticesPerSide + 8 * VerticesPerSide));
+    indices.reserve(static_cast<std::size_t>(TileCells * TileCells * 6 + 4 * TileCells * 6));
+
+    tile.minY = std::numeric_limits<float>::max();
+    tile.maxY = std::numeric_limits<float>::lowest();
+    const float step = static_cast<float>(spacing);
+    std::vector<std::uint32_t> normals(static_cast<std::size_t>(VerticesPerSide * VerticesPerSide));
+    for (int j = 0; j < VerticesPerSide; ++j)
+    {
+        for (int i = 0; i < VerticesPerSide; ++i)
+        {
+            const SurfaceSample& center = sample(i, j);
+            const float dx = sample(i - 1, j).height - sample(i + 1, j).height;
+            const float dz = sample(i, j - 1).height - sample(i, j + 1).height;
+            const std::uint32_t normal = renderer::pack_normal(glm::normalize(glm::vec3(dx, 2.0f * step, dz)));
+            normals[static_cast<std::size_t>(i + j * VerticesPerSide)] = normal;
+
+            const glm::vec3 position(static_cast<float>(i) * step, center.height, static_cast<float>(j) * step);
+            vertices.push_back(make_vertex(position, normal, {position.x, position.z}, face_layer(center.block, BlockFace::PosY)));
+            tile.minY = std::min(tile.minY, center.height);
+            tile.maxY = std::max(tile.maxY, center.height);
+        }
+    }
+
+    for (int j = 0; j < TileCells; ++j)
+    {
+        for (int i = 0; i < TileCells; ++i)
+        {
+            const std::uint32_t v00 = static_cast<std::uint32_t>(i + j * VerticesPerSide);
+            const std::uint32_t v10 = v00 + 1;
+            const std::uint32_t v01 = v00 + VerticesPerSide;
+            const std::uint32_t v11 = v01 + 1;
+            indices.insert(indices.end(), {v00, v01, v10, v10, v01, v11});
+        }
+    }
+
+    // Skirts: each edge is repeated skirtDepth lower and joined to itself. The far pass draws
+    // without face culling, so the winding does not matter.
+    const float skirtDepth = 2.0f * step;
+    const auto add_skirt = [&](int startI, int startJ, int stepI, int stepJ) {
+        const std::uint32_t base = static_cast<std::uint32_t>(vertices.size());
+        for (int n = 0; n < VerticesPerSide; ++n)
+        {
+            const int i = startI + stepI * n;
+            const int j = startJ + stepJ * n;
+            const SurfaceSample& edge = sample(i, j);
+            const std::uint32_t normal = normals[static_cast<std::size_t>(i + j * VerticesPerSide)];
+            const std::uint8_t layer = face_layer(edge.block, BlockFace::PosX);
+            const float along = static_cast<float>(n) * step;
+            const glm::vec3 top(static_cast<float>(i) * step, edge.height, static_cast<float>(j) * step);
+            vertices.push_back(make_vertex(top, normal, {along, top.y}, layer));
+            vertices.push_back(make_vertex(top - glm::vec3(0.0f, skirtDepth, 0.0f), normal, {along, top.y - skirtDepth}, layer));
+        }
+        for (std::uint32_t n = 0; n < static_cast<std::uint32_t>(TileCells); ++n)
+        {
+            const std::uint32_t top0 = base + n * 2;
+            indices.insert(indices.end(), {top0, top0 + 1, top0 + 2, top0 + 2, top0 + 1, top0 + 3});
+        }
+    };
+    add_skirt(0, 0, 1, 0);
+    add_skirt(0, TileCells, 1, 0);
+    add_skirt(0, 0, 0, 1);
+    add_skirt(TileCells, 0, 0, 1);
+    tile.minY -= skirtDepth;
+}
+
+void FarTerrain::gather_draw_commands(const renderer::Frustum& frustum, std::vector<FarDrawCommand>& commands) const
+{
+    commands.clear();
+    for (const auto& [key, tile] : m_tiles)
+    {
+        if (tile.mesh && !tile.mesh->empty() && frustum.intersects(tile.boundsMin, tile.boundsMax))
+            commands.push_back({tile.mesh.get(), tile.origin});
+    }
+}
+
+std::size_t FarTerrain::gpu_vertex_bytes() const
+{
+    std::size_t bytes = 0;
+    for (const auto& [key, tile] : m_tiles)
+    {
+        bytes += tile.mesh ? tile.mesh->vertex_bytes() : 0;
+    }
+    return bytes;
+}
+
+std::size_t FarTerrain::gpu_index_bytes() const
+{
+    std::size_t bytes = 0;
+    for (const auto& [key, tile] : m_tiles)
+    {
+        bytes += tile.mesh ? tile.mesh->index_bytes() : 0;
+    }
+    return bytes;
+}
+
+float FarTerrain::view_distance() const
+{
+    // The camera is at least two tiles from the near edge of the coarsest grid, so at most six
+    // from the far one.
+    const float reach = 6.0f * static_cast<float>(tile_size(m_levels - 1));
+    return reach * std::sqrt(2.0f);
+}
+
+} // namespace world
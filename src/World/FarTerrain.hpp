@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ChunkCoord.hpp"
+#include "ChunkMesh.hpp"
+#include "WorldGen.hpp"
+
+#include "Core/JobSystem.hpp"
+#include "Renderer/Frustum.hpp"
+#include "Renderer/GpuMesh.hpp"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace world
+{
+struct FarTileKey
+{
+    int level = 0;
+    int x = 0; // tile coordinates within the level
+    int z = 0;
+
+    auto operator<=>(const FarTileKey&) const = default;
+};
+
+} // namespace world
+
+namespace std
+{
+template <> struct hash<world::FarTileKey>
+{
+    std::size_t operator()(const world::FarTileKey& key) const noexcept
+    {
+        std::size_t seed = static_cast<std::size_t>(key.level);
+        seed = util::hash_combine(seed, static_cast<std::size_t>(key.x));
+        seed = util::hash_combine(seed, static_cast<std::size_t>(key.z));
+        return seed;
+    }
+};
+} // namespace std
+
+namespace world
+{
+struct FarDrawCommand
+{
+    const renderer::GpuMesh* mesh = nullptr;
+    glm::vec3 origin{0.0f};
+};
+
+// Horizon terrain past the voxel chunks, built from WorldGenerator::surface_map alone.
+//
+// The ground is a nested clipmap of heightfield tiles. Level L is a GridTiles x GridTiles grid
+// of tiles, each TileCells cells across with samples baseSpacing << L blocks apart, and a hole
+// exactly the size of level L - 1; level 0 only drops the tiles the voxel chunks cover. Every
+// grid snaps to even tile coordinates, so a level's hole always lines up with whole tiles of
+// the next. Tiles are keyed by level and position and kept for as long as they stay inside
+// their level, so moving the camera only builds the tiles that scroll in. Tile edges hang a
+// skirt down to hide cracks where a finer level meets a coarser one.
+class FarTerrain
+{
+  public:
+    static constexpr int TileCells = 32;
+    static constexpr int GridTiles = 8;
+
+    // Without a mesh factory (headless streaming) the far terrain stays empty.
+    FarTerrain(const WorldGenerator& generator, renderer::MeshFactory* meshes);
+
+    // Voxel chunks are drawn in the disc of voxelRadius chunks around voxelCenter
+    // (StreamingView::in_disc); level 0 leaves out the tiles that disc covers completely.
+    void update(const glm::vec3& cameraPosition, const ChunkCoord& voxelCenter, int voxelRadius);
+    void gather_draw_commands(const renderer::Frustum& frustum, std::vector<FarDrawCommand>& commands) const;
+
+    // Upper bound on the distance from the camera to any tile, for the far pass depth range.
+    float view_distance() const;
+    std::size_t tile_count() const { return m_tiles.size(); }
+    std::size_t pending_tiles() const { return m_inFlight.size(); }
+    // GPU memory allocated for the tiles' vertices and indices.
+    std::size_t gpu_vertex_bytes() const;
+    std::size_t gpu_index_bytes() const;
+
+  private:
+    struct Tile
+    {
+        std::unique_ptr<renderer::GpuMesh> mesh;
+        glm::vec3 origin{0.0f};
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+    };
+
+    struct BuiltTile
+    {
+        FarTileKey key;
+        MeshBuffers buffers;
+        float minY = 0.0f;
+        float maxY = 0.0f;
+    };
+
+    int tile_size(int level) const { return TileCells * (m_baseSpacing << level); }
+    void build_tile(BuiltTile& tile) const;
+    void process_built();
+
+    const WorldGenerator& m_generator;
+    renderer::MeshFactory* m_meshes;
+    bool m_enabled;
+    int m_levels;
+    int m_baseSpacing;
+
+    // Grid origin of every level in tile units, and the voxel area it was computed for.
+    std::vector<glm::ivec2> m_anchors;
+    ChunkCoord m_voxelCenter;
+    int m_voxelRadius = -1;
+
+    // Main thread only.
+    std::unordered_set<FarTileKey> m_wanted;
+    std::unordered_set<FarTileKey> m_inFlight;
+    std::unordered_map<FarTileKey, Tile> m_tiles;
+
+    std::mutex m_builtMutex;
+    std::vector<BuiltTile> m_built;
+
+    // Declared last so the worker is joined before the state its jobs touch is destroyed.
+    core::JobSystem m_jobs;
+};
+
+} // namespace world
@@ -3,8 +3,11 @@
 #include "AtlasUV.hpp"
 #include "BlockRegistry.hpp"
 
+#include "Core/Simd.hpp"
+
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <glm/glm.hpp>
 
 namespace world
@@ -14,22 +17,26 @@ namespace
 constexpr int UAxis[3] = {2, 0, 0};
 constexpr int VAxis[3] = {1, 2, 1};
 
-struct MaskCell
+// Largest mask any orientation needs at LOD0 (a 16x256 side slice).
+constexpr std::size_t MaxMaskCells = static_cast<std::size_t>(ChunkWidth * ChunkHeight);
+
+// Mask entries pack the face's block ID in the low 12 bits and the light level of the cell it
+// faces in the top 4, so the greedy merge only joins faces that share both.
+constexpr int MaskLightShift = 12;
+constexpr std::uint16_t MaskBlockBits = (1u << MaskLightShift) - 1;
+
+// Vertex brightness per light level; each level is 80% as bright as the one above it.
+constexpr std::array<std::uint8_t, MaxLightLevel + 1> LightCurve = {
+    9, 11, 14, 18, 22, 27, 34, 43, 53, 67, 84, 104, 131, 163, 204, 255};
+
+BlockID mask_key(BlockID block, std::uint8_t light)
 {
-    BlockID block = BlockAir;
-    bool filled = false;
-};
+    return block == BlockAir ? BlockAir : static_cast<BlockID>(block | (light << MaskLightShift));
+}
 
-std::uint32_t pack_normal(const glm::vec3& n)
+std::uint8_t light_level(std::uint8_t packed)
 {
-    const auto encode = [](float value) {
-        const float scaled = std::clamp((value * 0.5f + 0.5f) * 1023.0f, 0.0f, 1023.0f);
-        return static_cast<std::uint32_t>(scaled);
-    };
-    const std::uint32_t x = encode(n.x);
-    const std::uint32_t y = encode(n.y);
-    const std::uint32_t z = encode(n.z);
-    return (x & 0x3FFu) | ((y & 0x3FFu) << 10) | ((z & 0x3FFu) << 20);
+    return std::max<std::uint8_t>(packed >> 4, packed & 0x0F);
 }
 
 BlockID sample_block(const Chunk& chunk, const NeighborSet& neighbors, int x, int y, int z)
@@ -71,6 +78,37 @@ BlockID sample_block(const Chunk& chunk, const NeighborSet& neighbors, int x, in
     return BlockAir;
 }
 
+// Combined (max of sky and block) light level of a cell, read across chunk borders. Missing
+// neighbours count as open sky so borders do not flash dark before the neighbour streams in.
+std::uint8_t sample_light(const Chunk& chunk, const NeighborSet& neighbors, int x, int y, int z)
+{
+    const Chunk* source = &chunk;
+    if (x < 0)
+    {
+        source = neighbors.negX;
+        x += ChunkWidth;
+    }
+    else if (x >= ChunkWidth)
+    {
+        source = neighbors.posX;
+        x -= ChunkWidth;
+    }
+    else if (z < 0)
+    {
+        source = neighbors.negZ;
+        z += ChunkDepth;
+    }
+    else if (z >= ChunkDepth)
+    {
+        source = neighbors.posZ;
+        z -= ChunkDepth;
+    }
+
+    if (!source)
+        return MaxLightLevel;
+    return light_level(source->light(x, y, z));
+}
+
 bool is_opaque(BlockID id)
 {
     if (id == BlockAir)
@@ -92,6 +130,53 @@ bool is_fluid(BlockID id)
     return has_flag(registry().flags(id), BlockFlags::Fluid);
 }
 
+// Returns the block whose face is visible between owner and the cell it faces, or air when the
+// pair produces no face in this pass.
+BlockID face_block(BlockID owner, BlockID facing, bool opaquePass)
+{
+    if (owner == BlockAir)
+        return BlockAir;
+
+    if (opaquePass)
+    {
+        if (is_opaque(owner) && !is_opaque(facing) && !is_fluid(facing))
+            return owner;
+        return BlockAir;
+    }
+
+    if ((is_transparent(owner) || is_fluid(owner)) && !(is_transparent(facing) || is_fluid(facing)))
+        return owner;
+    return BlockAir;
+}
+
+// Layers are copied out rather than read in place because the main thread may be editing
+// the chunk while it is meshed.
+void copy_layer_at(const Chunk& chunk, int y, std::array<BlockID, SectionLayerArea>& out)
+{
+    if (y < 0 || y >= ChunkHeight)
+    {
+        out.fill(BlockAir);
+        return;
+    }
+    chunk.section(y / SectionSize).copy_layer(y % SectionSize, out.data());
+}
+
+// Light layer for y; out-of-column layers are fully sky-lit above and dark below.
+void copy_light_layer_at(const Chunk& chunk, int y, std::array<std::uint8_t, SectionLayerArea>& out)
+{
+    if (y >= ChunkHeight)
+    {
+        out.fill(static_cast<std::uint8_t>(MaxLightLevel << 4));
+        return;
+    }
+    if (y < 0)
+    {
+        out.fill(0);
+        return;
+    }
+    chunk.section(y / SectionSize).copy_light_layer(y % SectionSize, out.data());
+}
+
 BlockFace axis_face(int axis, bool positive)
 {
     switch (axis)
@@ -108,7 +193,8 @@ void emit_quad(std::vector<renderer::ChunkVertex>& vertices,
                const glm::vec3& du,
                const glm::vec3& dv,
                const glm::vec3& normal,
-               const AtlasUV& uv,
+               std::uint8_t layer,
+               std::uint8_t light,
                int w,
                int h,
                bool flip)
@@ -119,35 +205,38 @@ void emit_quad(std::vector<renderer::ChunkVertex>& vertices,
     renderer::ChunkVertex v2{};
     renderer::ChunkVertex v3{};
 
-    auto write_vertex = [](renderer::ChunkVertex& v, const glm::vec3& pos, const glm::vec2& uv, std::uint32_t packedNormal) {
+    auto write_vertex = [layer, light](renderer::ChunkVertex& v, const glm::vec3& pos, const glm::vec2& uv, std::uint32_t packedNormal) {
         v.position[0] = pos.x;
         v.position[1] = pos.y;
         v.position[2] = pos.z;
         v.normalPacked = packedNormal;
         v.uv[0] = uv.x;
         v.uv[1] = uv.y;
-        v.light = 255;
+        v.light = light;
+        v.layer = layer;
     };
 
-    const glm::vec2 uvSize = uv.uv1 - uv.uv0;
-    const glm::vec2 uvU = glm::vec2(uvSize.x * static_cast<float>(w), 0.0f);
-    const glm::vec2 uvV = glm::vec2(0.0f, uvSize.y * static_cast<float>(h));
+    // UVs are in tile units on a repeating array layer, so a w x h quad shows the block
+    // texture w x h times without sampling any neighbouring tile.
+    const glm::vec2 uv0(0.0f);
+    const glm::vec2 uvU(static_cast<float>(w), 0.0f);
+    const glm::vec2 uvV(0.0f, static_cast<float>(h));
 
-    const std::uint32_t packedNormal = pack_normal(glm::normalize(normal));
+    const std::uint32_t packedNormal = renderer::pack_normal(glm::normalize(normal));
 
     if (!flip)
     {
-        write_vertex(v0, origin, uv.uv0, packedNormal);
-        write_vertex(v1, origin + dv, uv.uv0 + uvV, packedNormal);
-        write_vertex(v2, origin + dv + du, uv.uv0 + uvV + uvU, packedNormal);
-        write_vertex(v3, origin + du, uv.uv0 + uvU, packedNormal);
+        write_vertex(v0, origin, uv0, packedNormal);
+        write_vertex(v1, origin + dv, uv0 + uvV, packedNormal);
+        write_vertex(v2, origin + dv + du, uv0 + uvV + uvU, packedNormal);
+        write_vertex(v3, origin + du, uv0 + uvU, packedNormal);
     }
     else
     {
-        write_vertex(v0, origin, uv.uv0, packedNormal);
-        write_vertex(v1, origin + du, uv.uv0 + uvU, packedNormal);
-        write_vertex(v2, origin + du + dv, uv.uv0 + uvU + uvV, packedNormal);
-        write_vertex(v3, origin + dv, uv.uv0 + uvV, packedNormal);
+        write_vertex(v0, origin, uv0, packedNormal);
+        write_vertex(v1, origin + du, uv0 + uvU, packedNormal);
+        write_vertex(v2, origin + du + dv, uv0 + uvU + uvV, packedNormal);
+        write_vertex(v3, origin + dv, uv0 + uvV, packedNormal);
     }
 
     vertices.push_back(v0);
@@ -163,27 +252,53 @@ void emit_quad(std::vector<renderer::ChunkVertex>& vertices,
     indices.push_back(base + 3);
 }
 
-} // namespace
+// Which slices of an orientation build_slices meshes.
+enum class SliceSet
+{
+    Interior,
+    Border
+};
 
-// GreedyMesher collapses coplanar faces within a chunk section by building a 2D mask per
-// axis (positive and negative). Each mask entry stores the block ID that should contribute
-// a face; spans of identical blocks are merged into a single quad. This dramatically reduces
-// triangle counts compared to naive voxel meshing, especially for large flat surfaces.
-void GreedyMesher::build(const Chunk& chunk,
-                         const NeighborSet& neighbors,
-                         std::uint8_t lod,
-                         bool opaquePass,
-                         std::vector<renderer::ChunkVertex>& vertices,
-                         std::vector<std::uint32_t>& indices)
+// Appends the faces of a single axis orientation (axis * 2, +1 for the negative side) found in
+// the given slices.
+void build_slices(const Chunk& chunk,
+                  const NeighborSet& neighbors,
+                  std::uint8_t lod,
+                  bool opaquePass,
+                  int orientation,
+                  SliceSet slices,
+                  MesherScratch& scratch,
+                  std::vector<renderer::ChunkVertex>& vertices,
+                  std::vector<std::uint32_t>& indices)
 {
-    vertices.clear();
-    indices.clear();
+    const int axis = orientation / 2;
+    const bool positive = (orientation % 2) == 0;
+    const int uAxis = UAxis[axis];
+    const int vAxis = VAxis[axis];
 
     const int step = 1 << lod;
     const int dims[3] = {ChunkWidth / step, ChunkHeight / step, ChunkDepth / step};
     const float stepF = static_cast<float>(step);
 
-    std::vector<MaskCell> mask(static_cast<std::size_t>(dims[UAxis[0]] * dims[VAxis[0]]));
+    // Faces belong to the chunk's own blocks, so nothing above its tallest non-empty section
+    // can produce one and the vertical extent is clipped to it. Neighbours only matter on the
+    // border planes, which keeps the interior independent of them.
+    const int contentCells = std::min(dims[1], (chunk.content_height() + step - 1) / step);
+
+    const int maskWidth = dims[uAxis];
+    const int maskHeight = vAxis == 1 ? contentCells : dims[vAxis];
+    const std::size_t maskCells = static_cast<std::size_t>(maskWidth * maskHeight);
+
+    auto& mask = scratch.mask;
+    if (mask.size() < MaxMaskCells)
+    {
+        mask.resize(MaxMaskCells);
+    }
+    auto& airBits = scratch.airBits;
+    if (airBits.size() < MaxMaskCells / 64)
+    {
+        airBits.resize(MaxMaskCells / 64);
+    }
 
     auto sampleAgg = [&](int ax, int ay, int az) {
         const int x = ax * step;
@@ -191,162 +306,208 @@ void GreedyMesher::build(const Chunk& chunk,
         const int z = az * step;
         return sample_block(chunk, neighbors, x, y, z);
     };
+    auto sampleLightAgg = [&](int ax, int ay, int az) {
+        return sample_light(chunk, neighbors, ax * step, ay * step, az * step);
+    };
+
+    // A chunk only emits faces of its own blocks: the owner cell sits at slice - 1 for positive
+    // faces and at slice for negative ones, and the face lies on the plane between owner and
+    // the cell it faces.
+    const int sliceLimit = axis == 1 ? contentCells : dims[axis];
+    int firstSlice = positive ? 1 : 0;
+    int lastSlice = positive ? sliceLimit : sliceLimit - 1;
+
+    // The X and Z axes end in a border plane, the outermost slice, whose faces look into the
+    // neighbour; the vertical axis has none.
+    if (axis == 1)
+    {
+        if (slices == SliceSet::Border)
+            return;
+    }
+    else if (slices == SliceSet::Border)
+    {
+        firstSlice = lastSlice = positive ? lastSlice : firstSlice;
+    }
+    else
+    {
+        if (positive)
+            --lastSlice;
+        else
+            ++firstSlice;
+    }
 
-    auto process_orientation = [&](int axis, bool positive) {
-        const int uAxis = UAxis[axis];
-        const int vAxis = VAxis[axis];
-        const int maskWidth = dims[uAxis];
-        const int maskHeight = dims[vAxis];
-        mask.assign(static_cast<std::size_t>(maskWidth * maskHeight), {});
+    for (int slice = firstSlice; slice <= lastSlice; ++slice)
+    {
+        const int ownerSlice = positive ? slice - 1 : slice;
+        const int facingSlice = positive ? slice : slice - 1;
 
-        for (int slice = 0; slice <= dims[axis]; ++slice)
+        if (axis == 1 && lod == 0)
+        {
+            // Horizontal faces at full resolution read whole 16x16 layers, which are contiguous
+            // in ChunkSection storage and match the mask layout (x fastest, then z).
+            std::array<BlockID, SectionLayerArea> owner;
+            std::array<BlockID, SectionLayerArea> facing;
+            copy_layer_at(chunk, ownerSlice, owner);
+            copy_layer_at(chunk, facingSlice, facing);
+            if (core::simd::all_equal_u16(owner.data(), SectionLayerArea, owner[0]) &&
+                core::simd::all_equal_u16(facing.data(), SectionLayerArea, owner[0]))
+            {
+                // Identical uniform layers on both sides never produce a face.
+                continue;
+            }
+            std::array<std::uint8_t, SectionLayerArea> facingLight;
+            copy_light_layer_at(chunk, facingSlice, facingLight);
+
+            core::simd::fill_u16(mask.data(), maskCells, BlockAir);
+            core::simd::equal_mask_u16(owner.data(), SectionLayerArea, BlockAir, airBits.data());
+            for (std::size_t word = 0; word < SectionLayerArea / 64; ++word)
+            {
+                std::uint64_t solid = ~airBits[word];
+                while (solid)
+                {
+                    const std::size_t index = word * 64 + static_cast<std::size_t>(std::countr_zero(solid));
+                    solid &= solid - 1;
+                    mask[index] = mask_key(face_block(owner[index], facing[index], opaquePass), light_level(facingLight[index]));
+                }
+            }
+        }
+        else
         {
-            // Build mask for current slice.
             for (int j = 0; j < maskHeight; ++j)
             {
                 for (int i = 0; i < maskWidth; ++i)
                 {
-                    int coord[3];
-                    coord[axis] = slice + (positive ? -1 : 0);
-                    coord[uAxis] = i;
-                    coord[vAxis] = j;
-
-                    int neighborCoord[3] = {coord[0], coord[1], coord[2]};
-                    neighborCoord[axis] = coord[axis] + (positive ? 1 : -1);
+                    int ownerCoord[3];
+                    ownerCoord[axis] = ownerSlice;
+                    ownerCoord[uAxis] = i;
+                    ownerCoord[vAxis] = j;
 
-                    const BlockID front = sampleAgg(coord[0], coord[1], coord[2]);
-                    const BlockID back = sampleAgg(neighborCoord[0], neighborCoord[1], neighborCoord[2]);
+                    int facingCoord[3] = {ownerCoord[0], ownerCoord[1], ownerCoord[2]};
+                    facingCoord[axis] = facingSlice;
 
+                    const BlockID ownerBlock = sampleAgg(ownerCoord[0], ownerCoord[1], ownerCoord[2]);
                     const std::size_t index = static_cast<std::size_t>(i + j * maskWidth);
-                    mask[index].filled = false;
-
-                    if (positive)
-                    {
-                        if (!front || front == BlockAir)
-                            continue;
-
-                        if (opaquePass)
-                        {
-                            if (is_opaque(front) && !is_opaque(back) && !is_fluid(back))
-                            {
-                                mask[index].filled = true;
-                                mask[index].block = front;
-                            }
-                        }
-                        else
-                        {
-                            if ((is_transparent(front) || is_fluid(front)) && !(is_transparent(back) || is_fluid(back)))
-                            {
-                                mask[index].filled = true;
-                                mask[index].block = front;
-                            }
-                        }
-                    }
-                    else
+                    if (ownerBlock == BlockAir)
                     {
-                        if (!back || back == BlockAir)
-                            continue;
-
-                        if (opaquePass)
-                        {
-                            if (is_opaque(back) && !is_opaque(front) && !is_fluid(front))
-                            {
-                                mask[index].filled = true;
-                                mask[index].block = back;
-                            }
-                        }
-                        else
-                        {
-                            if ((is_transparent(back) || is_fluid(back)) && !(is_transparent(front) || is_fluid(front)))
-                            {
-                                mask[index].filled = true;
-                                mask[index].block = back;
-                            }
-                        }
+                        mask[index] = BlockAir;
+                        continue;
                     }
+                    const BlockID block = face_block(ownerBlock, sampleAgg(facingCoord[0], facingCoord[1], facingCoord[2]), opaquePass);
+                    mask[index] = block == BlockAir
+                                      ? BlockAir
+                                      : mask_key(block, sampleLightAgg(facingCoord[0], facingCoord[1], facingCoord[2]));
                 }
             }
+        }
 
-            // Greedy merge over mask.
-            for (int j = 0; j < maskHeight; ++j)
+        // Greedy merge over mask. Runs of equal keys are found with the SIMD run-length kernel,
+        // rows below are checked with the uniformity kernel and consumed cells are bulk cleared.
+        for (int j = 0; j < maskHeight; ++j)
+        {
+            BlockID* row = mask.data() + static_cast<std::size_t>(j * maskWidth);
+            for (int i = 0; i < maskWidth;)
             {
-                for (int i = 0; i < maskWidth;)
+                const BlockID key = row[i];
+                const std::size_t remaining = static_cast<std::size_t>(maskWidth - i);
+                if (key == BlockAir)
                 {
-                    const std::size_t idx = static_cast<std::size_t>(i + j * maskWidth);
-                    if (!mask[idx].filled)
-                    {
-                        ++i;
-                        continue;
-                    }
+                    i += static_cast<int>(core::simd::run_length_u16(row + i, remaining, BlockAir));
+                    continue;
+                }
 
-                    const BlockID block = mask[idx].block;
-                    int width = 1;
-                    while (i + width < maskWidth)
-                    {
-                        const std::size_t next = static_cast<std::size_t>(i + width + j * maskWidth);
-                        if (!mask[next].filled || mask[next].block != block)
-                            break;
-                        ++width;
-                    }
+                const int width = static_cast<int>(core::simd::run_length_u16(row + i, remaining, key));
 
-                    int height = 1;
-                    bool done = false;
-                    while (j + height < maskHeight && !done)
-                    {
-                        for (int k = 0; k < width; ++k)
-                        {
-                            const std::size_t next = static_cast<std::size_t>(i + k + (j + height) * maskWidth);
-                            if (!mask[next].filled || mask[next].block != block)
-                            {
-                                done = true;
-                                break;
-                            }
-                        }
-                        if (!done)
-                        {
-                            ++height;
-                        }
-                    }
+                int height = 1;
+                while (j + height < maskHeight &&
+                       core::simd::all_equal_u16(row + i + height * maskWidth, static_cast<std::size_t>(width), key))
+                {
+                    ++height;
+                }
 
-                    for (int y = 0; y < height; ++y)
-                    {
-                        for (int x = 0; x < width; ++x)
-                        {
-                            const std::size_t clearIdx = static_cast<std::size_t>(i + x + (j + y) * maskWidth);
-                            mask[clearIdx].filled = false;
-                        }
-                    }
+                for (int y = 0; y < height; ++y)
+                {
+                    core::simd::fill_u16(row + i + y * maskWidth, static_cast<std::size_t>(width), BlockAir);
+                }
 
-                    const auto& def = registry().definition(block);
-                    const auto& faceUV = def.faces[static_cast<int>(axis_face(axis, positive))];
-                    const AtlasUV uv = atlas_uv(faceUV);
+                const auto& def = registry().definition(static_cast<BlockID>(key & MaskBlockBits));
+                const auto& faceUV = def.faces[static_cast<int>(axis_face(axis, positive))];
+                const std::uint8_t layer = tile_layer(faceUV);
 
-                    glm::vec3 origin(0.0f);
-                    glm::vec3 du(0.0f);
-                    glm::vec3 dv(0.0f);
-                    glm::vec3 normal(0.0f);
+                glm::vec3 origin(0.0f);
+                glm::vec3 du(0.0f);
+                glm::vec3 dv(0.0f);
+                glm::vec3 normal(0.0f);
 
-                    origin[axis] = static_cast<float>(slice) * stepF;
-                    origin[uAxis] = static_cast<float>(i) * stepF;
-                    origin[vAxis] = static_cast<float>(j) * stepF;
+                origin[axis] = static_cast<float>(slice) * stepF;
+                origin[uAxis] = static_cast<float>(i) * stepF;
+                origin[vAxis] = static_cast<float>(j) * stepF;
 
-                    du[uAxis] = static_cast<float>(width) * stepF;
-                    dv[vAxis] = static_cast<float>(height) * stepF;
+                du[uAxis] = static_cast<float>(width) * stepF;
+                dv[vAxis] = static_cast<float>(height) * stepF;
 
-                    normal[axis] = positive ? 1.0f : -1.0f;
+                normal[axis] = positive ? 1.0f : -1.0f;
 
-                    const bool flip = !positive;
-                    emit_quad(vertices, indices, origin, du, dv, normal, uv, width, height, flip);
-                }
+                const bool flip = !positive;
+                const std::uint8_t light = LightCurve[key >> MaskLightShift];
+                emit_quad(vertices, indices, origin, du, dv, normal, layer, light, width, height, flip);
+
+                i += width;
             }
         }
-    };
+    }
+}
+
+} // namespace
 
-    for (int axis = 0; axis < 3; ++axis)
+// GreedyMesher collapses coplanar faces within a chunk section by building a 2D mask per
+// axis (positive and negative). Each mask entry stores the block ID that should contribute
+// a face (tagged with the light level in front of it), or air for none; spans of identical
+// entries are merged into a single quad. This
+// dramatically reduces triangle counts compared to naive voxel meshing, especially for large
+// flat surfaces.
+void GreedyMesher::build_part(const Chunk& chunk,
+                              const NeighborSet& neighbors,
+                              std::uint8_t lod,
+                              bool opaquePass,
+                              MeshPart part,
+                              MesherScratch& scratch,
+                              std::vector<renderer::ChunkVertex>& vertices,
+                              std::vector<std::uint32_t>& indices)
+{
+    vertices.clear();
+    indices.clear();
+
+    for (int orientation = 0; orientation < OrientationCount; ++orientation)
     {
-        process_orientation(axis, true);
-        process_orientation(axis, false);
+        if (part == MeshPart::Interior)
+            build_slices(chunk, neighbors, lod, opaquePass, orientation, SliceSet::Interior, scratch, vertices, indices);
+        else if (border_part(orientation) == part)
+            build_slices(chunk, neighbors, lod, opaquePass, orientation, SliceSet::Border, scratch, vertices, indices);
     }
 }
 
+void GreedyMesher::build_interior(const Chunk& chunk,
+                                  const NeighborSet& neighbors,
+                                  std::uint8_t lod,
+                                  bool opaquePass,
+                                  int orientation,
+                                  MesherScratch& scratch,
+                                  std::vector<renderer::ChunkVertex>& vertices,
+                                  std::vector<std::uint32_t>& indices)
+{
+    build_slices(chunk, neighbors, lod, opaquePass, orientation, SliceSet::Interior, scratch, vertices, indices);
+}
+
+MeshPart GreedyMesher::border_part(int orientation)
+{
+    constexpr MeshPart Borders[OrientationCount] = {MeshPart::PosX, MeshPart::NegX, MeshPart::Interior, MeshPart::Interior, MeshPart::PosZ, MeshPart::NegZ};
+    return Borders[orientation];
+}
+
+MesherScratch& GreedyMesher::worker_scratch()
+{
+    thread_local MesherScratch scratch;
+    return scratch;
+}
+
 } // namespace world
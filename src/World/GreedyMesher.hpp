@@ -1,8 +1,9 @@
 #pragma once
 
 #include "Chunk.hpp"
+#include "ChunkMesh.hpp"
 
-#include "Renderer/Mesh.hpp"
+#include "Renderer/GpuMesh.hpp"
 
 #include <vector>
 
@@ -16,15 +17,47 @@ struct NeighborSet
     const Chunk* negZ = nullptr;
 };
 
+// Temporaries reused across GreedyMesher::build_part and build_interior calls. Each meshing
+// worker owns one (see GreedyMesher::worker_scratch) so the per-slice mask is sized once and
+// never reallocated.
+struct MesherScratch
+{
+    std::vector<BlockID> mask;
+    std::vector<std::uint64_t> airBits;
+};
+
 class GreedyMesher
 {
   public:
-    static void build(const Chunk& chunk,
-                      const NeighborSet& neighbors,
-                      std::uint8_t lod,
-                      bool opaquePass,
-                      std::vector<renderer::ChunkVertex>& vertices,
-                      std::vector<std::uint32_t>& indices);
+    static constexpr int OrientationCount = 6;
+
+    // Replaces vertices and indices with one part of the chunk mesh (see MeshPart). The
+    // interior never reads the neighbours; a border strip reads the neighbour across it.
+    static void build_part(const Chunk& chunk,
+                           const NeighborSet& neighbors,
+                           std::uint8_t lod,
+                           bool opaquePass,
+                           MeshPart part,
+                           MesherScratch& scratch,
+                           std::vector<renderer::ChunkVertex>& vertices,
+                           std::vector<std::uint32_t>& indices);
+
+    // Appends the interior faces of a single orientation; the six in order make up the
+    // interior part.
+    static void build_interior(const Chunk& chunk,
+                               const NeighborSet& neighbors,
+                               std::uint8_t lod,
+                               bool opaquePass,
+                               int orientation,
+                               MesherScratch& scratch,
+                               std::vector<renderer::ChunkVertex>& vertices,
+                               std::vector<std::uint32_t>& indices);
+
+    // The border strip holding an orientation's outermost slice, or Interior for the vertical
+    // orientations, which have none.
+    static MeshPart border_part(int orientation);
+
+    static MesherScratch& worker_scratch();
 };
 
 } // namespace world
@@ -0,0 +1,422 @@
+#include "LightEngine.hpp"
+
+#include "BlockRegistry.hpp"
+
+#include "Util/Math.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace world
+{
+namespace
+{
+const std::array<glm::ivec3, 6> Directions = {
+    glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+    glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1)};
+constexpr int DownDirection = 3;
+
+std::uint8_t channel_level(std::uint8_t packed, LightChannel channel)
+{
+    return channel == LightChannel::Sky ? static_cast<std::uint8_t>(packed >> 4) : static_cast<std::uint8_t>(packed & 0x0F);
+}
+
+std::uint8_t with_level(std::uint8_t packed, LightChannel channel, std::uint8_t level)
+{
+    return channel == LightChannel::Sky ? static_cast<std::uint8_t>((packed & 0x0F) | (level << 4))
+                                        : static_cast<std::uint8_t>((packed & 0xF0) | level);
+}
+
+// Level light of `level` arrives with after stepping into a block of the given opacity, moving in
+// direction `dir`. Full sky light falls straight down through clear blocks without dimming.
+std::uint8_t attenuate(std::uint8_t level, std::uint8_t opacity, LightChannel channel, int dir)
+{
+    if (channel == LightChannel::Sky && dir == DownDirection && level == MaxLightLevel && opacity == 0)
+        return MaxLightLevel;
+    const std::uint8_t loss = std::max<std::uint8_t>(1, opacity);
+    return level > loss ? static_cast<std::uint8_t>(level - loss) : 0;
+}
+
+// World-space view over the chunks reachable from one light operation. Chunks are resolved
+// through the lookup once per operation. Without a lookup only the home chunk is visible, and
+// no borders are reported.
+class LightRegion
+{
+  public:
+    LightRegion(const LightEngine::ChunkLookup* lookup, Chunk& home, std::vector<ChunkCoord>& touched, std::vector<LitBorder>* borders)
+        : m_lookup(lookup), m_home(&home), m_touched(touched), m_borders(borders)
+    {
+        m_cache.push_back({home.coord(), &home});
+    }
+
+    // Chunk holding world column (x, z) and the local coordinates inside it, or null if that
+    // chunk is not available.
+    Chunk* resolve(int x, int z, int& localX, int& localZ)
+    {
+        const ChunkCoord coord{util::floor_div(x, ChunkWidth), util::floor_div(z, ChunkDepth)};
+        localX = x - coord.x * ChunkWidth;
+        localZ = z - coord.z * ChunkDepth;
+
+        for (const auto& cached : m_cache)
+        {
+            if (cached.coord == coord)
+                return cached.chunk;
+        }
+
+        Chunk* chunk = m_lookup ? (*m_lookup)(coord) : nullptr;
+        m_cache.push_back({coord, chunk});
+        return chunk;
+    }
+
+    void set(Chunk& chunk, int localX, int y, int localZ, std::uint8_t packed)
+    {
+        chunk.set_light(localX, y, localZ, packed);
+        if (&chunk != m_home && std::find(m_touched.begin(), m_touched.end(), chunk.coord()) == m_touched.end())
+        {
+            m_touched.push_back(chunk.coord());
+        }
+
+        if (!m_borders)
+            return;
+        const ChunkCoord coord = chunk.coord();
+        if (localX == 0)
+            add_border(coord, {coord.x - 1, coord.z});
+        else if (localX == ChunkWidth - 1)
+            add_border(coord, {coord.x + 1, coord.z});
+        if (localZ == 0)
+            add_border(coord, {coord.x, coord.z - 1});
+        else if (localZ == ChunkDepth - 1)
+            add_border(coord, {coord.x, coord.z + 1});
+    }
+
+  private:
+    void add_border(const ChunkCoord& changed, const ChunkCoord& neighbor)
+    {
+        const LitBorder border{changed, neighbor};
+        if (neighbor != m_home->coord() && std::find(m_borders->begin(), m_borders->end(), border) == m_borders->end())
+            m_borders->push_back(border);
+    }
+
+    struct CachedChunk
+    {
+        ChunkCoord coord;
+        Chunk* chunk;
+    };
+
+    const LightEngine::ChunkLookup* m_lookup;
+    Chunk* m_home;
+    std::vector<ChunkCoord>& m_touched;
+    std::vector<LitBorder>* m_borders;
+    std::vector<CachedChunk> m_cache;
+};
+
+// Spreads light outward from every queued node until no neighbour can be brightened.
+void propagate_add(LightRegion& region, LightChannel channel, std::vector<LightEngine::Node>& queue)
+{
+    const BlockRegistry& blocks = registry();
+    for (std::size_t head = 0; head < queue.size(); ++head)
+    {
+        const LightEngine::Node node = queue[head];
+        int localX = 0;
+        int localZ = 0;
+        Chunk* chunk = region.resolve(node.x, node.z, localX, localZ);
+        if (!chunk)
+            continue;
+
+        // The node may have been lowered or raised since it was queued; spread what is there now.
+        const std::uint8_t level = channel_level(chunk->light(localX, node.y, localZ), channel);
+        if (level <= 1)
+            continue;
+
+        for (int dir = 0; dir < static_cast<int>(Directions.size()); ++dir)
+        {
+            const glm::ivec3 next = glm::ivec3(node.x, node.y, node.z) + Directions[dir];
+            if (next.y < 0 || next.y >= ChunkHeight)
+                continue;
+
+            int nextX = 0;
+            int nextZ = 0;
+            Chunk* target = region.resolve(next.x, next.z, nextX, nextZ);
+            if (!target)
+                continue;
+
+            const std::uint8_t opacity = blocks.light_opacity(target->get(nextX, next.y, nextZ));
+            if (opacity >= MaxLightLevel)
+                continue;
+
+            const std::uint8_t arriving = attenuate(level, opacity, channel, dir);
+            const std::uint8_t packed = target->light(nextX, next.y, nextZ);
+            if (arriving > channel_level(packed, channel))
+            {
+                region.set(*target, nextX, next.y, nextZ, with_level(packed, channel, arriving));
+                queue.push_back({next.x, next.y, next.z, arriving});
+            }
+        }
+    }
+    queue.clear();
+}
+
+// Darkens every cell whose light came from the queued nodes (each carrying the level it had
+// before being cleared). Brighter cells at the edge of the darkened area, and emitters inside
+// it, are queued on `refill` so propagate_add can flow light back in.
+void propagate_remove(LightRegion& region,
+                      LightChannel channel,
+                      std::vector<LightEngine::Node>& queue,
+                      std::vector<LightEngine::Node>& refill)
+{
+    const BlockRegistry& blocks = registry();
+    for (std::size_t head = 0; head < queue.size(); ++head)
+    {
+        const LightEngine::Node node = queue[head];
+        for (int dir = 0; dir < static_cast<int>(Directions.size()); ++dir)
+        {
+            const glm::ivec3 next = glm::ivec3(node.x, node.y, node.z) + Directions[dir];
+            if (next.y < 0 || next.y >= ChunkHeight)
+                continue;
+
+            int nextX = 0;
+            int nextZ = 0;
+            Chunk* target = region.resolve(next.x, next.z, nextX, nextZ);
+            if (!target)
+                continue;
+
+            const std::uint8_t packed = target->light(nextX, next.y, nextZ);
+            const std::uint8_t level = channel_level(packed, channel);
+            if (level == 0)
+                continue;
+
+            const bool fedByNode = level < node.level ||
+                                   (channel == LightChannel::Sky && dir == DownDirection && node.level == MaxLightLevel &&
+                                    level == MaxLightLevel);
+            if (!fedByNode)
+            {
+                refill.push_back({next.x, next.y, next.z, level});
+                continue;
+            }
+
+            const std::uint8_t emission =
+                channel == LightChannel::Block ? blocks.light_emission(target->get(nextX, next.y, nextZ)) : 0;
+            region.set(*target, nextX, next.y, nextZ, with_level(packed, channel, emission));
+            queue.push_back({next.x, next.y, next.z, level});
+            if (emission > 0)
+            {
+                refill.push_back({next.x, next.y, next.z, emission});
+            }
+        }
+    }
+    queue.clear();
+}
+
+// Chunk-local pass: sky light falls down each column, emitters are seeded, and both are
+// spread inside the chunk. Nothing outside the chunk is read or written.
+void flood_local(const ChunkPtr& chunk, std::vector<LightEngine::Node>& queue)
+{
+    const BlockRegistry& blocks = registry();
+    const ChunkCoord coord = chunk->coord();
+    const int originX = coord.x * ChunkWidth;
+    const int originZ = coord.z * ChunkDepth;
+    const int contentHeight = chunk->content_height();
+
+    // A uniform section of an opaque, dark block is black throughout. Darkening it as a whole
+    // first makes the per-cell writes below no-ops, so buried stone stays unallocated.
+    for (int index = 0; index < SectionCount; ++index)
+    {
+        ChunkSection& section = chunk->section(index);
+        BlockID value = BlockAir;
+        if (!section.allocated() && section.uniform(value) && blocks.light_opacity(value) >= MaxLightLevel &&
+            blocks.light_emission(value) == 0)
+        {
+            section.fill_light(0);
+        }
+    }
+
+    // Sections start fully sky-lit, so only the cells below the top of the content need
+    // writing. skyTop is the lowest y from which the column is lit at full strength.
+    std::array<int, ChunkWidth * ChunkDepth> skyTop{};
+    for (int z = 0; z < ChunkDepth; ++z)
+    {
+        for (int x = 0; x < ChunkWidth; ++x)
+        {
+            std::uint8_t level = MaxLightLevel;
+            int top = contentHeight;
+            for (int y = contentHeight - 1; y >= 0; --y)
+            {
+                if (level > 0)
+                {
+                    const std::uint8_t opacity = blocks.light_opacity(chunk->get(x, y, z));
+                    level = opacity >= level ? 0 : static_cast<std::uint8_t>(level - opacity);
+                    if (level == MaxLightLevel)
+                        top = y;
+                }
+                chunk->set_light(x, y, z, static_cast<std::uint8_t>(level << 4));
+            }
+            skyTop[static_cast<std::size_t>(x + z * ChunkWidth)] = top;
+        }
+    }
+
+    // Seed every sky-lit cell that sits next to a darker column inside the chunk, plus the
+    // partially lit cells under fluids, and every emitter.
+    for (int z = 0; z < ChunkDepth; ++z)
+    {
+        for (int x = 0; x < ChunkWidth; ++x)
+        {
+            const int top = skyTop[static_cast<std::size_t>(x + z * ChunkWidth)];
+            int highestNeighbor = top;
+            if (x > 0)
+                highestNeighbor = std::max(highestNeighbor, skyTop[static_cast<std::size_t>(x - 1 + z * ChunkWidth)]);
+            if (x + 1 < ChunkWidth)
+                highestNeighbor = std::max(highestNeighbor, skyTop[static_cast<std::size_t>(x + 1 + z * ChunkWidth)]);
+            if (z > 0)
+                highestNeighbor = std::max(highestNeighbor, skyTop[static_cast<std::size_t>(x + (z - 1) * ChunkWidth)]);
+            if (z + 1 < ChunkDepth)
+                highestNeighbor = std::max(highestNeighbor, skyTop[static_cast<std::size_t>(x + (z + 1) * ChunkWidth)]);
+
+            for (int y = top; y < highestNeighbor; ++y)
+            {
+                queue.push_back({originX + x, y, originZ + z, MaxLightLevel});
+            }
+            for (int y = top - 1; y >= 0; --y)
+            {
+                const std::uint8_t level = chunk->light(x, y, z) >> 4;
+                if (level <= 1)
+                    break;
+                queue.push_back({originX + x, y, originZ + z, level});
+            }
+        }
+    }
+
+    std::vector<ChunkCoord> touched;
+    LightRegion region(nullptr, *chunk, touched, nullptr);
+    propagate_add(region, LightChannel::Sky, queue);
+
+    for (int sectionIndex = 0; sectionIndex < SectionCount; ++sectionIndex)
+    {
+        if (chunk->section(sectionIndex).empty())
+            continue;
+
+        for (int y = sectionIndex * SectionSize; y < (sectionIndex + 1) * SectionSize; ++y)
+        {
+            for (int z = 0; z < ChunkDepth; ++z)
+            {
+                for (int x = 0; x < ChunkWidth; ++x)
+                {
+                    const std::uint8_t emission = blocks.light_emission(chunk->get(x, y, z));
+                    if (emission == 0)
+                        continue;
+                    chunk->set_light(x, y, z, with_level(chunk->light(x, y, z), LightChannel::Block, emission));
+                    queue.push_back({originX + x, y, originZ + z, emission});
+                }
+            }
+        }
+    }
+    propagate_add(region, LightChannel::Block, queue);
+}
+} // namespace
+
+LightEngine::LightEngine(ChunkLookup lookup) : m_lookup(std::move(lookup))
+{
+}
+
+void LightEngine::light_chunk(const ChunkPtr& chunk, std::vector<ChunkCoord>& touched, std::vector<LitBorder>& litBorders)
+{
+    thread_local std::vector<Node> localQueue;
+    flood_local(chunk, localQueue);
+
+    std::lock_guard lock(m_mutex);
+    chunk->set_lit(true);
+
+    LightRegion region(&m_lookup, *chunk, touched, &litBorders);
+    const ChunkCoord coord = chunk->coord();
+    const int originX = coord.x * ChunkWidth;
+    const int originZ = coord.z * ChunkDepth;
+
+    // Seed both sides of every border shared with a lit neighbour and let the flood run across
+    // it in either direction. Above both columns' content everything is full sky on both sides,
+    // but block light can still reach up to MaxLightLevel cells past the top emitter.
+    struct Border
+    {
+        int dx;
+        int dz;
+    };
+    constexpr std::array<Border, 4> borders = {Border{1, 0}, Border{-1, 0}, Border{0, 1}, Border{0, -1}};
+
+    for (const LightChannel channel : {LightChannel::Sky, LightChannel::Block})
+    {
+        for (const Border& border : borders)
+        {
+            int neighborX = 0;
+            int neighborZ = 0;
+            Chunk* neighbor = region.resolve(originX + border.dx * ChunkWidth, originZ + border.dz * ChunkDepth, neighborX, neighborZ);
+            if (!neighbor)
+                continue;
+
+            int height = std::max(chunk->content_height(), neighbor->content_height());
+            if (channel == LightChannel::Block)
+                height = std::min(ChunkHeight, height + MaxLightLevel);
+            for (int i = 0; i < ChunkWidth; ++i)
+            {
+                // Local cell on our side of the border and the world cell just across it.
+                const int x = border.dx != 0 ? (border.dx > 0 ? ChunkWidth - 1 : 0) : i;
+                const int z = border.dz != 0 ? (border.dz > 0 ? ChunkDepth - 1 : 0) : i;
+                for (int y = 0; y < height; ++y)
+                {
+                    const std::uint8_t ours = channel_level(chunk->light(x, y, z), channel);
+                    if (ours > 1)
+                        m_addQueue.push_back({originX + x, y, originZ + z, ours});
+
+                    const int acrossX = originX + x + border.dx;
+                    const int acrossZ = originZ + z + border.dz;
+                    int localX = 0;
+                    int localZ = 0;
+                    Chunk* across = region.resolve(acrossX, acrossZ, localX, localZ);
+                    const std::uint8_t theirs = channel_level(across->light(localX, y, localZ), channel);
+                    if (theirs > 1)
+                        m_addQueue.push_back({acrossX, y, acrossZ, theirs});
+                }
+            }
+        }
+        propagate_add(region, channel, m_addQueue);
+    }
+}
+
+void LightEngine::update_block(const glm::ivec3& worldPos, std::vector<ChunkCoord>& touched, std::vector<LitBorder>& litBorders)
+{
+    std::lock_guard lock(m_mutex);
+
+    Chunk* home = m_lookup({util::floor_div(worldPos.x, ChunkWidth), util::floor_div(worldPos.z, ChunkDepth)});
+    if (!home)
+        return;
+
+    LightRegion region(&m_lookup, *home, touched, &litBorders);
+    int localX = 0;
+    int localZ = 0;
+    Chunk* chunk = region.resolve(worldPos.x, worldPos.z, localX, localZ);
+    const BlockID block = chunk->get(localX, worldPos.y, localZ);
+
+    for (const LightChannel channel : {LightChannel::Block, LightChannel::Sky})
+    {
+        // Clear the edited cell and everything it fed, then let light flow back in from the
+        // surviving neighbours and from the new block itself if it glows.
+        const std::uint8_t packed = chunk->light(localX, worldPos.y, localZ);
+        const std::uint8_t previous = channel_level(packed, channel);
+        const std::uint8_t emission = channel == LightChannel::Block ? registry().light_emission(block) : 0;
+        region.set(*chunk, localX, worldPos.y, localZ, with_level(packed, channel, emission));
+        if (previous > 0)
+        {
+            m_removeQueue.push_back({worldPos.x, worldPos.y, worldPos.z, previous});
+            propagate_remove(region, channel, m_removeQueue, m_addQueue);
+        }
+
+        if (emission > 0)
+            m_addQueue.push_back({worldPos.x, worldPos.y, worldPos.z, emission});
+        for (const glm::ivec3& dir : Directions)
+        {
+            const glm::ivec3 next = worldPos + dir;
+            if (next.y >= 0 && next.y < ChunkHeight)
+                m_addQueue.push_back({next.x, next.y, next.z, 0});
+        }
+        propagate_add(region, channel, m_addQueue);
+    }
+}
+
+} // namespace world
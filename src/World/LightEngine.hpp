@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Chunk.hpp"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace world
+{
+enum class LightChannel : std::uint8_t
+{
+    Sky,
+    Block
+};
+
+// Light that changed on a chunk's border cells, which the faces of the neighbour across that
+// border sample; the neighbour's strip facing `changed` needs rebuilding.
+struct LitBorder
+{
+    ChunkCoord changed;
+    ChunkCoord neighbor;
+
+    bool operator==(const LitBorder&) const = default;
+};
+
+// Flood-fill sky and block light. A freshly generated chunk is lit in two steps:
+//   1. light_chunk() floods the chunk on its own (no locking, runs on generation workers);
+//   2. it then exchanges light across its borders with every neighbour that is already lit.
+// Step 2 and incremental edits walk into neighbouring chunks and are serialised by one mutex.
+// Chunks other than the starting one whose light changed are reported through `touched` so the
+// caller can remesh them. Light changed on any chunk's border is reported through `litBorders`,
+// except on borders with the starting chunk, which the caller remeshes whole.
+class LightEngine
+{
+  public:
+    // Returns a loaded, lit chunk for the coordinate or null. Must be safe to call from workers,
+    // and the chunk must stay alive until the light operation that asked for it returns (the
+    // streamer's callers hold an epoch guard for that).
+    using ChunkLookup = std::function<Chunk*(const ChunkCoord&)>;
+
+    explicit LightEngine(ChunkLookup lookup);
+
+    void light_chunk(const ChunkPtr& chunk, std::vector<ChunkCoord>& touched, std::vector<LitBorder>& litBorders);
+
+    // Re-propagates light around worldPos after its block changed. The chunk holding worldPos
+    // must already contain the new block.
+    void update_block(const glm::ivec3& worldPos, std::vector<ChunkCoord>& touched, std::vector<LitBorder>& litBorders);
+
+    struct Node
+    {
+        int x;
+        int y;
+        int z;
+        std::uint8_t level;
+    };
+
+  private:
+    ChunkLookup m_lookup;
+    std::mutex m_mutex;
+    // BFS queues reused by everything that runs under m_mutex.
+    std::vector<Node> m_addQueue;
+    std::vector<Node> m_removeQueue;
+};
+
+} // namespace world
@@ -0,0 +1,45 @@
+#include "MemoryBudget.hpp"
+
+namespace world
+{
+const char* category_name(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::Voxels:
+        return "voxels";
+    case MemoryCategory::CpuMeshes:
+        return "cpuMeshes";
+    case MemoryCategory::GpuVertices:
+        return "gpuVertices";
+    case MemoryCategory::GpuIndices:
+        return "gpuIndices";
+    case MemoryCategory::Jobs:
+        return "jobs";
+    }
+    return "unknown";
+}
+
+MemoryBudget::MemoryBudget(const config::MemorySettings& settings)
+    : m_caps{settings.voxelBytes, settings.cpuMeshBytes, settings.gpuVertexBytes, settings.gpuIndexBytes, settings.jobBytes}
+{
+}
+
+std::size_t MemoryBudget::excess(MemoryCategory category) const
+{
+    const std::size_t limit = cap(category);
+    const std::size_t bytes = used(category);
+    return limit != 0 && bytes > limit ? bytes - limit : 0;
+}
+
+std::size_t MemoryBudget::total() const
+{
+    std::size_t bytes = 0;
+    for (const std::size_t used : m_used)
+    {
+        bytes += used;
+    }
+    return bytes;
+}
+
+} // namespace world
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace world
+{
+enum class MemoryCategory : std::uint8_t
+{
+    Voxels,      // Blocks and light of loaded chunks.
+    CpuMeshes,   // CPU copies of chunk meshes.
+    GpuVertices, // Vertex buffers of chunk meshes and far terrain tiles, as allocated.
+    GpuIndices,  // Their index buffers.
+    Jobs,        // Finished meshes waiting for the GPU and pooled mesh buffers.
+};
+
+constexpr int MemoryCategoryCount = 5;
+
+const char* category_name(MemoryCategory category);
+
+// What the streamer holds per category against the caps in config::MemorySettings. The
+// streamer recounts every category once per update, so the numbers are exact rather than
+// kept in step with every allocation, and frees what it can in the categories past their cap.
+// Main (update) thread only.
+class MemoryBudget
+{
+  public:
+    explicit MemoryBudget(const config::MemorySettings& settings);
+
+    void set_used(MemoryCategory category, std::size_t bytes) { m_used[index(category)] = bytes; }
+    std::size_t used(MemoryCategory category) const { return m_used[index(category)]; }
+    std::size_t cap(MemoryCategory category) const { return m_caps[index(category)]; }
+
+    bool over(MemoryCategory category) const { return excess(category) > 0; }
+    // Bytes to free to get back under the cap.
+    std::size_t excess(MemoryCategory category) const;
+    std::size_t total() const;
+
+  private:
+    static std::size_t index(MemoryCategory category) { return static_cast<std::size_t>(category); }
+
+    std::array<std::size_t, MemoryCategoryCount> m_caps{};
+    std::array<std::size_t, MemoryCategoryCount> m_used{};
+};
+
+} // namespace world
@@ -0,0 +1,121 @@
+#include "MeshBufferPool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace world
+{
+namespace
+{
+
+// Headroom over the running average so a typical chunk fits without a regrow.
+std::size_t reserve_quads(std::uint32_t estimate)
+{
+    return static_cast<std::size_t>(estimate) + estimate / 4 + 16;
+}
+} // namespace
+
+MeshBufferPool::MeshBufferPool(std::size_t maxPooledPerKind) : m_maxPooledPerKind(maxPooledPerKind)
+{
+    for (auto& list : m_free)
+    {
+        list.reserve(m_maxPooledPerKind);
+    }
+}
+
+MeshBuffers MeshBufferPool::acquire(std::uint8_t lod, bool opaquePass, MeshPart part)
+{
+    const std::size_t k = kind(lod, opaquePass, part);
+    MeshBuffers buffers;
+    {
+        std::lock_guard lock(m_mutex);
+        auto& list = m_free[k];
+        if (!list.empty())
+        {
+            buffers = std::move(list.back());
+            list.pop_back();
+        }
+    }
+
+    const std::size_t quads = reserve_quads(static_cast<std::uint32_t>(estimated_quads(lod, opaquePass, part)));
+    if (buffers.vertices.capacity() < quads * 4)
+        buffers.vertices.reserve(quads * 4);
+    if (buffers.indices.capacity() < quads * 6)
+        buffers.indices.reserve(quads * 6);
+    return buffers;
+}
+
+void MeshBufferPool::release(std::uint8_t lod, bool opaquePass, MeshBuffers&& buffers, MeshPart part)
+{
+    if (buffers.vertices.capacity() == 0 && buffers.indices.capacity() == 0)
+        return;
+
+    buffers.vertices.clear();
+    buffers.indices.clear();
+
+    std::lock_guard lock(m_mutex);
+    auto& list = m_free[kind(lod, opaquePass, part)];
+    if (list.size() < m_maxPooledPerKind)
+    {
+        list.push_back(std::move(buffers));
+    }
+}
+
+void MeshBufferPool::record_quads(std::uint8_t lod, bool opaquePass, std::size_t quads, MeshPart part)
+{
+    // Exponential moving average with a 1/8 weight, kept in eighths of a quad so small samples
+    // still move it; lost updates between workers only perturb the estimate slightly, so a
+    // relaxed read-modify-write is sufficient.
+    auto& estimate = m_quadEstimate[kind(lod, opaquePass, part)];
+    const std::uint32_t previous = estimate.load(std::memory_order_relaxed);
+    const std::uint32_t sample = static_cast<std::uint32_t>(std::min<std::size_t>(quads, UINT32_MAX / EstimateScale));
+    const std::uint32_t next = previous == 0 ? sample * EstimateScale : previous - (previous + EstimateScale / 2) / EstimateScale + sample;
+    estimate.store(next, std::memory_order_relaxed);
+}
+
+std::size_t MeshBufferPool::estimated_quads(std::uint8_t lod, bool opaquePass, MeshPart part) const
+{
+    return (m_quadEstimate[kind(lod, opaquePass, part)].load(std::memory_order_relaxed) + EstimateScale / 2) / EstimateScale;
+}
+
+std::size_t MeshBufferPool::pooled() const
+{
+    std::lock_guard lock(m_mutex);
+    std::size_t total = 0;
+    for (const auto& list : m_free)
+    {
+        total += list.size();
+    }
+    return total;
+}
+
+std::size_t MeshBufferPool::pooled_bytes() const
+{
+    std::lock_guard lock(m_mutex);
+    std::size_t bytes = 0;
+    for (const auto& list : m_free)
+    {
+        for (const MeshBuffers& buffers : list)
+        {
+            bytes += buffer_bytes(buffers);
+        }
+    }
+    return bytes;
+}
+
+std::size_t MeshBufferPool::trim()
+{
+    std::lock_guard lock(m_mutex);
+    std::size_t freed = 0;
+    for (auto& list : m_free)
+    {
+        for (const MeshBuffers& buffers : list)
+        {
+            freed += buffer_bytes(buffers);
+        }
+        list.clear();
+    }
+    return freed;
+}
+
+} // namespace world
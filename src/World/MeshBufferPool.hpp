@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ChunkMesh.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace world
+{
+// Recycles MeshBuffers between mesh jobs and ChunkMesh. Buffers handed out by acquire() are
+// pre-reserved from a running estimate of quads per (LOD, pass, interior or border strip) so
+// emit_quad never grows them, and buffers given back after an upload keep their capacity for
+// the next job.
+class MeshBufferPool
+{
+  public:
+    explicit MeshBufferPool(std::size_t maxPooledPerKind = 128);
+
+    MeshBuffers acquire(std::uint8_t lod, bool opaquePass, MeshPart part = MeshPart::Interior);
+    void release(std::uint8_t lod, bool opaquePass, MeshBuffers&& buffers, MeshPart part = MeshPart::Interior);
+
+    void record_quads(std::uint8_t lod, bool opaquePass, std::size_t quads, MeshPart part = MeshPart::Interior);
+    std::size_t estimated_quads(std::uint8_t lod, bool opaquePass, MeshPart part = MeshPart::Interior) const;
+
+    std::size_t pooled() const;
+    // Memory held by the pooled buffers, and freeing all of it; trim() returns the bytes freed.
+    std::size_t pooled_bytes() const;
+    std::size_t trim();
+
+  private:
+    // Border strips are a sliver of the interior, so they are pooled and estimated apart.
+    static constexpr std::size_t KindCount = 12;
+    static std::size_t kind(std::uint8_t lod, bool opaquePass, MeshPart part)
+    {
+        return static_cast<std::size_t>(lod) * 4 + (opaquePass ? 0 : 1) + (part == MeshPart::Interior ? 0 : 2);
+    }
+
+    // The estimates are fixed point, in eighths of a quad.
+    static constexpr std::uint32_t EstimateScale = 8;
+
+    mutable std::mutex m_mutex;
+    std::array<std::vector<MeshBuffers>, KindCount> m_free;
+    std::array<std::atomic<std::uint32_t>, KindCount> m_quadEstimate{};
+    std::size_t m_maxPooledPerKind;
+};
+
+} // namespace world
@@ -0,0 +1,573 @@
+#include "RegionStore.hpp"
+
+#include "Util/Hash.hpp"
+#include "Util/Logging.hpp"
+
+#include <array>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace world
+{
+namespace
+{
+constexpr std::uint32_t FileMagic = 0x47524343; // "CCRG"
+constexpr std::uint32_t FileVersion = 1;
+constexpr int SlotCount = RegionStore::RegionSize * RegionStore::RegionSize;
+// More open regions than this and the least recently used unreferenced one is closed.
+constexpr std::size_t MaxOpenRegions = 16;
+// A region is rewritten once dead records outweigh live ones and exceed this.
+constexpr std::uint64_t CompactionThreshold = 1u << 20;
+
+struct FileHeader
+{
+    std::uint32_t magic = FileMagic;
+    std::uint32_t version = FileVersion;
+    std::uint64_t configHash = 0;
+    std::int32_t regionX = 0;
+    std::int32_t regionZ = 0;
+    std::uint64_t reserved = 0;
+};
+
+// A slot with size 0 is empty.
+struct Slot
+{
+    std::uint64_t offset = 0;
+    std::uint32_t size = 0;
+    std::uint32_t reserved = 0;
+    std::uint64_t checksum = 0;
+};
+
+constexpr std::uint64_t TableOffset = sizeof(FileHeader);
+constexpr std::uint64_t DataOffset = TableOffset + SlotCount * sizeof(Slot);
+
+ChunkCoord region_of(const ChunkCoord& coord)
+{
+    // Arithmetic shifts round towards negative infinity, as region coordinates must.
+    return {coord.x >> 5, coord.z >> 5};
+}
+
+int slot_of(const ChunkCoord& coord)
+{
+    return (coord.x & (RegionStore::RegionSize - 1)) + (coord.z & (RegionStore::RegionSize - 1)) * RegionStore::RegionSize;
+}
+
+static_assert(RegionStore::RegionSize == 1 << 5, "region_of shifts by log2(RegionSize)");
+
+// A read-only view of a region file as of when it was mapped. Readers keep the mapping alive
+// for as long as they use it, so remapping after an append never pulls bytes out from under
+// them.
+class Mapping
+{
+  public:
+    Mapping(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size) {}
+    ~Mapping()
+    {
+#if !defined(_WIN32)
+        if (m_data)
+            munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    const std::uint8_t* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+#if defined(_WIN32)
+    // Without mmap the file is read into memory instead.
+    std::vector<std::uint8_t> copy;
+#endif
+
+  private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+};
+
+// Positioned reads and writes on one file. Only the writer thread writes; reads of the table
+// happen while the region is being opened.
+class RegionFile
+{
+  public:
+    RegionFile() = default;
+    ~RegionFile() { close(); }
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    bool open(const std::filesystem::path& path, bool create)
+    {
+        close();
+#if defined(_WIN32)
+        m_file = _wfopen(path.c_str(), L"r+b");
+        if (!m_file && create)
+            m_file = _wfopen(path.c_str(), L"w+b");
+        return m_file != nullptr;
+#else
+        m_fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        return m_fd >= 0;
+#endif
+    }
+
+    bool is_open() const
+    {
+#if defined(_WIN32)
+        return m_file != nullptr;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (m_file)
+            std::fclose(m_file);
+        m_file = nullptr;
+#else
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_fd = -1;
+#endif
+    }
+
+    std::uint64_t size() const
+    {
+#if defined(_WIN32)
+        if (_fseeki64(m_file, 0, SEEK_END) != 0)
+            return 0;
+        return static_cast<std::uint64_t>(_ftelli64(m_file));
+#else
+        struct stat info{};
+        return fstat(m_fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+#endif
+    }
+
+    bool read(std::uint64_t offset, void* data, std::size_t size) const
+    {
+#if defined(_WIN32)
+        return _fseeki64(m_file, static_cast<long long>(offset), SEEK_SET) == 0 && std::fread(data, 1, size, m_file) == size;
+#else
+        auto* bytes = static_cast<std::uint8_t*>(data);
+        while (size > 0)
+        {
+            const ssize_t count = pread(m_fd, bytes, size, static_cast<off_t>(offset));
+            if (count <= 0)
+                return false;
+            bytes += count;
+            offset += static_cast<std::uint64_t>(count);
+            size -= static_cast<std::size_t>(count);
+        }
+        return true;
+#endif
+    }
+
+    bool write(std::uint64_t offset, const void* data, std::size_t size)
+    {
+#if defined(_WIN32)
+        return _fseeki64(m_file, static_cast<long long>(offset), SEEK_SET) == 0 && std::fwrite(data, 1, size, m_file) == size &&
+               std::fflush(m_file) == 0;
+#else
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        while (size > 0)
+        {
+            const ssize_t count = pwrite(m_fd, bytes, size, static_cast<off_t>(offset));
+            if (count <= 0)
+                return false;
+            bytes += count;
+            offset += static_cast<std::uint64_t>(count);
+            size -= static_cast<std::size_t>(count);
+        }
+        return true;
+#endif
+    }
+
+    // Returns once everything written so far is on the storage device, not just handed to the
+    // operating system, so later writes cannot reach the disk ahead of it.
+    bool sync()
+    {
+#if defined(_WIN32)
+        return std::fflush(m_file) == 0 && _commit(_fileno(m_file)) == 0;
+#else
+        return fdatasync(m_fd) == 0;
+#endif
+    }
+
+    // Maps the first size bytes; null on failure.
+    std::shared_ptr<const Mapping> map(std::uint64_t size) const
+    {
+        if (size == 0 || size > std::numeric_limits<std::size_t>::max())
+            return nullptr;
+#if defined(_WIN32)
+        std::vector<std::uint8_t> copy(static_cast<std::size_t>(size));
+        if (!read(0, copy.data(), copy.size()))
+            return nullptr;
+        auto mapping = std::make_shared<Mapping>(copy.data(), copy.size());
+        mapping->copy = std::move(copy);
+        return mapping;
+#else
+        void* data = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED)
+            return nullptr;
+        return std::make_shared<Mapping>(static_cast<const std::uint8_t*>(data), static_cast<std::size_t>(size));
+#endif
+    }
+
+  private:
+#if defined(_WIN32)
+    std::FILE* m_file = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+} // namespace
+
+struct RegionStore::Region
+{
+    std::mutex mutex;
+    ChunkCoord coord;
+    std::uint64_t configHash = 0;
+    std::filesystem::path path;
+    // Not opened until there is a file: looking a chunk up never creates one.
+    RegionFile file;
+    // False for regions of another world and for files that could not be opened.
+    bool usable = false;
+    std::array<Slot, SlotCount> table{};
+    // Records are appended here.
+    std::uint64_t end = DataOffset;
+    std::uint64_t liveBytes = 0;
+    std::shared_ptr<const Mapping> mapping;
+    std::uint64_t lastUse = 0;
+
+    bool open()
+    {
+        std::error_code error;
+        if (!std::filesystem::exists(path, error))
+            return true;
+
+        if (!file.open(path, false))
+        {
+            util::log().error("Cannot open region %s", path.string().c_str());
+            return false;
+        }
+
+        // A file too short to hold its table never held a record.
+        const std::uint64_t size = file.size();
+        if (size < DataOffset)
+            return create();
+
+        FileHeader header;
+        if (!file.read(0, &header, sizeof(header)) || header.magic != FileMagic || header.version != FileVersion)
+        {
+            util::log().error("%s is not a region file; leaving it alone", path.string().c_str());
+            return false;
+        }
+        if (header.configHash != configHash)
+        {
+            util::log().warn("%s belongs to a world with another generator config; leaving it alone", path.string().c_str());
+            return false;
+        }
+        if (!file.read(TableOffset, table.data(), sizeof(Slot) * table.size()))
+        {
+            util::log().error("Cannot read the table of region %s", path.string().c_str());
+            return false;
+        }
+
+        // Slots pointing past the end were written before their record made it to disk.
+        end = size;
+        for (Slot& slot : table)
+        {
+            if (slot.size != 0 && (slot.offset < DataOffset || slot.offset + slot.size > end))
+                slot = {};
+            liveBytes += slot.size;
+        }
+        return true;
+    }
+
+    // Writes a header and an empty table.
+    bool create()
+    {
+        FileHeader header;
+        header.configHash = configHash;
+        header.regionX = coord.x;
+        header.regionZ = coord.z;
+        table = {};
+        end = DataOffset;
+        liveBytes = 0;
+        if (!file.open(path, true) || !file.write(0, &header, sizeof(header)) ||
+            !file.write(TableOffset, table.data(), sizeof(Slot) * table.size()))
+        {
+            util::log().error("Cannot create region %s", path.string().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // A mapping covering [offset, offset + size), remapping if the file grew since.
+    std::shared_ptr<const Mapping> mapping_for(std::uint64_t offset, std::uint64_t size)
+    {
+        if (!mapping || mapping->size() < offset + size)
+            mapping = file.map(end);
+        return mapping;
+    }
+
+    // Rewrites the file with only the live records. Readers holding the old mapping keep
+    // reading the old file until they let go of it.
+    void compact()
+    {
+        auto source = mapping_for(0, end);
+        if (!source)
+            return;
+
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        RegionFile target;
+        if (!target.open(tempPath, true))
+            return;
+
+        FileHeader header;
+        header.configHash = configHash;
+        header.regionX = coord.x;
+        header.regionZ = coord.z;
+        std::array<Slot, SlotCount> compacted{};
+        std::uint64_t offset = DataOffset;
+        bool ok = target.write(0, &header, sizeof(header));
+        for (int index = 0; ok && index < SlotCount; ++index)
+        {
+            const Slot& slot = table[static_cast<std::size_t>(index)];
+            if (slot.size == 0)
+                continue;
+            ok = target.write(offset, source->data() + slot.offset, slot.size);
+            compacted[static_cast<std::size_t>(index)] = Slot{offset, slot.size, 0, slot.checksum};
+            offset += slot.size;
+        }
+        // Synced before the rename, or a power loss could leave the new name on an empty file.
+        ok = ok && target.write(TableOffset, compacted.data(), sizeof(Slot) * compacted.size()) && target.sync();
+        target.close();
+
+        // Closed first so the rename also works where open files cannot be replaced.
+        std::error_code error;
+        file.close();
+        if (ok)
+            std::filesystem::rename(tempPath, path, error);
+        if (!ok || error)
+        {
+            util::log().warn("Compacting region %s failed; keeping it as is", path.string().c_str());
+            std::filesystem::remove(tempPath, error);
+            ok = false;
+        }
+        if (!file.open(path, false))
+        {
+            util::log().error("Cannot reopen region %s", path.string().c_str());
+            usable = false;
+        }
+        if (ok)
+        {
+            table = compacted;
+            end = offset;
+        }
+        mapping.reset();
+    }
+};
+
+RegionStore::RegionStore(std::filesystem::path directory, std::uint64_t configHash)
+    : m_directory(std::move(directory))
+    , m_configHash(configHash)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+        util::log().error("Cannot create world directory %s", m_directory.string().c_str());
+
+    m_writer = std::thread([this]() { writer_loop(); });
+}
+
+RegionStore::~RegionStore()
+{
+    {
+        std::lock_guard lock(m_queueMutex);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    m_writer.join();
+}
+
+void RegionStore::save(const ChunkCoord& coord, std::vector<std::uint8_t> record)
+{
+    auto shared = std::make_shared<const std::vector<std::uint8_t>>(std::move(record));
+    {
+        std::lock_guard lock(m_queueMutex);
+        auto& pending = m_pending[coord];
+        if (!pending)
+            m_queue.push_back(coord);
+        pending = std::move(shared);
+    }
+    m_queueChanged.notify_all();
+}
+
+bool RegionStore::load(const ChunkCoord& coord, const std::function<bool(const std::uint8_t*, std::size_t)>& read)
+{
+    std::shared_ptr<const std::vector<std::uint8_t>> queued;
+    {
+        std::lock_guard lock(m_queueMutex);
+        if (auto it = m_pending.find(coord); it != m_pending.end())
+            queued = it->second;
+    }
+    if (queued)
+        return read(queued->data(), queued->size());
+
+    auto region = open_region(region_of(coord));
+    Slot slot;
+    std::shared_ptr<const Mapping> mapping;
+    {
+        std::lock_guard lock(region->mutex);
+        if (!region->usable)
+            return false;
+        slot = region->table[static_cast<std::size_t>(slot_of(coord))];
+        if (slot.size == 0)
+            return false;
+        mapping = region->mapping_for(slot.offset, slot.size);
+    }
+    if (!mapping)
+        return false;
+
+    const std::uint8_t* data = mapping->data() + slot.offset;
+    if (util::fnv1a(data, slot.size) != slot.checksum)
+    {
+        util::log().warn("Stored chunk (%d, %d) is corrupt; ignoring it", coord.x, coord.z);
+        return false;
+    }
+    return read(data, slot.size);
+}
+
+bool RegionStore::contains(const ChunkCoord& coord)
+{
+    {
+        std::lock_guard lock(m_queueMutex);
+        if (m_pending.contains(coord))
+            return true;
+    }
+    auto region = open_region(region_of(coord));
+    std::lock_guard lock(region->mutex);
+    return region->usable && region->table[static_cast<std::size_t>(slot_of(coord))].size != 0;
+}
+
+bool RegionStore::writable(const ChunkCoord& coord)
+{
+    auto region = open_region(region_of(coord));
+    std::lock_guard lock(region->mutex);
+    return region->usable;
+}
+
+void RegionStore::flush()
+{
+    std::unique_lock lock(m_queueMutex);
+    m_queueChanged.wait(lock, [this] { return m_pending.empty(); });
+}
+
+std::size_t RegionStore::pending_writes() const
+{
+    std::lock_guard lock(m_queueMutex);
+    return m_pending.size();
+}
+
+std::shared_ptr<RegionStore::Region> RegionStore::open_region(const ChunkCoord& coord)
+{
+    std::lock_guard lock(m_regionMutex);
+    auto& region = m_regions[coord];
+    if (!region)
+    {
+        region = std::make_shared<Region>();
+        region->coord = coord;
+        region->configHash = m_configHash;
+        region->path = m_directory / ("r." + std::to_string(coord.x) + "." + std::to_string(coord.z) + ".ccr");
+        region->usable = region->open();
+    }
+    region->lastUse = ++m_regionClock;
+    auto result = region;
+
+    // Regions in use elsewhere stay open; they are closed on a later call.
+    if (m_regions.size() > MaxOpenRegions)
+    {
+        auto oldest = m_regions.end();
+        for (auto it = m_regions.begin(); it != m_regions.end(); ++it)
+        {
+            if (it->second.use_count() == 1 && (oldest == m_regions.end() || it->second->lastUse < oldest->second->lastUse))
+                oldest = it;
+        }
+        if (oldest != m_regions.end())
+            m_regions.erase(oldest);
+    }
+    return result;
+}
+
+// Queued records are written oldest first. A record replaced while being written goes back
+// in the queue, so the newest one always reaches the disk.
+void RegionStore::writer_loop()
+{
+    std::unique_lock lock(m_queueMutex);
+    while (true)
+    {
+        m_queueChanged.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+        if (m_queue.empty())
+            return;
+
+        const ChunkCoord coord = m_queue.front();
+        m_queue.pop_front();
+        const auto record = m_pending.at(coord);
+
+        lock.unlock();
+        write(coord, *record);
+        lock.lock();
+
+        auto it = m_pending.find(coord);
+        if (it->second == record)
+            m_pending.erase(it);
+        else
+            m_queue.push_back(coord);
+        m_queueChanged.notify_all();
+    }
+}
+
+void RegionStore::write(const ChunkCoord& coord, const std::vector<std::uint8_t>& record)
+{
+    auto region = open_region(region_of(coord));
+    std::lock_guard lock(region->mutex);
+    if (!region->usable || record.empty() || record.size() > std::numeric_limits<std::uint32_t>::max())
+        return;
+    if (!region->file.is_open() && !(region->usable = region->create()))
+        return;
+
+    // The record goes to disk before the slot that points at it; the sync in between keeps the
+    // kernel from flushing the slot first, which a power loss would otherwise expose.
+    const Slot slot{region->end, static_cast<std::uint32_t>(record.size()), 0, util::fnv1a(record.data(), record.size())};
+    const std::size_t index = static_cast<std::size_t>(slot_of(coord));
+    if (!region->file.write(slot.offset, record.data(), record.size()) || !region->file.sync() ||
+        !region->file.write(TableOffset + index * sizeof(Slot), &slot, sizeof(slot)))
+    {
+        util::log().error("Writing chunk (%d, %d) to %s failed", coord.x, coord.z, region->path.string().c_str());
+        return;
+    }
+
+    region->liveBytes += slot.size;
+    region->liveBytes -= region->table[index].size;
+    region->table[index] = slot;
+    region->end += slot.size;
+
+    const std::uint64_t deadBytes = region->end - DataOffset - region->liveBytes;
+    if (deadBytes > region->liveBytes && deadBytes > CompactionThreshold)
+        region->compact();
+}
+
+} // namespace world
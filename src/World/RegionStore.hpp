@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ChunkCoord.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace world
+{
+// Chunk records on disk, grouped into region files of RegionSize x RegionSize chunks
+// (r.<x>.<z>.ccr) so a world is a handful of files rather than one per chunk. Records are
+// opaque here; the streamer and the pregeneration tool store ChunkCodec records.
+//
+// A region file is a header fingerprinting the generator config, then one table slot per
+// chunk (offset, size and checksum of its record), then the records. A record is appended
+// and synced to the device before its slot is rewritten, so a write interrupted by a crash or
+// a power loss leaves the previous record or a checksum mismatch, never a mix. Replaced
+// records are dead space until the region is mostly dead, at which point it is rewritten.
+//
+// Reads come straight out of a read-only memory map of the region, without copying; writes
+// are queued and performed by one background thread, and a record still in the queue is
+// served from there. Thread-safe.
+class RegionStore
+{
+  public:
+    static constexpr int RegionSize = 32;
+
+    // Regions written under another config fingerprint belong to a different world and are
+    // neither read nor overwritten.
+    RegionStore(std::filesystem::path directory, std::uint64_t configHash);
+    // Finishes every queued write.
+    ~RegionStore();
+
+    RegionStore(const RegionStore&) = delete;
+    RegionStore& operator=(const RegionStore&) = delete;
+
+    // Queues the record for writing; it replaces any record of the chunk still queued.
+    void save(const ChunkCoord& coord, std::vector<std::uint8_t> record);
+
+    // Calls read with the chunk's record and returns its result, or returns false if no
+    // intact record is stored. The bytes are only valid during the call.
+    bool load(const ChunkCoord& coord, const std::function<bool(const std::uint8_t*, std::size_t)>& read);
+    bool contains(const ChunkCoord& coord);
+    // False if the coordinate's region belongs to another world or cannot be opened.
+    bool writable(const ChunkCoord& coord);
+
+    // Blocks until every queued record has been written.
+    void flush();
+    std::size_t pending_writes() const;
+
+  private:
+    struct Region;
+
+    std::shared_ptr<Region> open_region(const ChunkCoord& coord);
+    void writer_loop();
+    void write(const ChunkCoord& coord, const std::vector<std::uint8_t>& record);
+
+    std::filesystem::path m_directory;
+    std::uint64_t m_configHash;
+
+    // Open regions by region coordinate; the least recently used are closed past a limit.
+    std::mutex m_regionMutex;
+    std::unordered_map<ChunkCoord, std::shared_ptr<Region>> m_regions;
+    std::uint64_t m_regionClock = 0;
+
+    // Records waiting for the writer, one per chunk, and the order they were queued in.
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueChanged;
+    std::unordered_map<ChunkCoord, std::shared_ptr<const std::vector<std::uint8_t>>> m_pending;
+    std::deque<ChunkCoord> m_queue;
+    bool m_stopping = false;
+
+    // Declared last: started once everything it uses exists.
+    std::thread m_writer;
+};
+
+} // namespace world
@@ -0,0 +1,94 @@
+#include "StreamingView.hpp"
+
+#include "Chunk.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace world
+{
+namespace
+{
+// Velocity follows the camera with this time constant, so a single long frame or a brief
+// stop does not swing the prefetch target around.
+constexpr float VelocitySmoothing = 0.25f;
+// Jumps longer than this many chunks in one frame are teleports, not motion.
+constexpr float TeleportDistance = 4.0f;
+
+// Re-ranking thresholds: half a chunk of travel, about 10 degrees of turn, or a change in
+// velocity that moves the prefetch target by one chunk.
+constexpr float RerankDistance = 0.5f;
+constexpr float RerankTurnCos = 0.985f;
+constexpr float RerankLead = 1.0f;
+} // namespace
+
+StreamingView::StreamingView(int loadRadius)
+    : m_prefetchSeconds(std::max(config::streaming().prefetchSeconds, 0.0f))
+    , m_viewCos(std::cos(glm::radians(config::streaming().viewHalfAngle)))
+    , m_viewBonus(std::clamp(config::streaming().viewBonus, 0.0f, 1.0f))
+    // Looking further ahead than the load area reaches would only rank its far edge first.
+    , m_maxLead(static_cast<float>(loadRadius))
+{
+}
+
+void StreamingView::update(const glm::vec3& position, const glm::vec3& forward, float dt)
+{
+    const glm::vec2 current(position.x / ChunkWidth, position.z / ChunkDepth);
+    if (m_hasPosition && dt > 0.0f)
+    {
+        const glm::vec2 delta = current - m_position;
+        if (glm::length(delta) > TeleportDistance)
+        {
+            m_velocity = glm::vec2(0.0f);
+        }
+        else
+        {
+            const float blend = 1.0f - std::exp(-dt / VelocitySmoothing);
+            m_velocity += (delta / dt - m_velocity) * blend;
+        }
+    }
+    m_position = current;
+    m_hasPosition = true;
+
+    // Looking straight up or down keeps the last horizontal direction.
+    const glm::vec2 flat(forward.x, forward.z);
+    if (glm::length(flat) > 1e-3f)
+        m_forward = glm::normalize(flat);
+}
+
+float StreamingView::priority(const ChunkCoord& coord) const
+{
+    const glm::vec2 center(static_cast<float>(coord.x) + 0.5f, static_cast<float>(coord.z) + 0.5f);
+    const glm::vec2 offset = center - m_position;
+    const float distance = glm::length(offset);
+
+    glm::vec2 lead = m_velocity * m_prefetchSeconds;
+    const float leadLength = glm::length(lead);
+    if (leadLength > m_maxLead)
+        lead *= m_maxLead / leadLength;
+    float ranked = std::min(distance, glm::length(center - (m_position + lead)));
+
+    // The chunks around the camera are always needed, whichever way it faces.
+    if (distance > 1.5f && glm::dot(offset, m_forward) >= m_viewCos * distance)
+        ranked *= m_viewBonus;
+    return ranked;
+}
+
+bool StreamingView::stale() const
+{
+    const glm::vec2 leadChange = (m_velocity - m_rankedVelocity) * m_prefetchSeconds;
+    return glm::length(m_position - m_rankedPosition) > RerankDistance || glm::dot(m_forward, m_rankedForward) < RerankTurnCos ||
+           glm::length(leadChange) > RerankLead;
+}
+
+void StreamingView::mark_ranked()
+{
+    m_rankedPosition = m_position;
+    m_rankedForward = m_forward;
+    m_rankedVelocity = m_velocity;
+}
+
+} // namespace world
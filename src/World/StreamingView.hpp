@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ChunkCoord.hpp"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace world
+{
+// An observer as the streamer sees it: position, horizontal view direction and a smoothed
+// velocity, all in chunk units. Ranks chunks for generation, lower first.
+class StreamingView
+{
+  public:
+    explicit StreamingView(int loadRadius);
+
+    void update(const glm::vec3& position, const glm::vec3& forward, float dt);
+
+    // Lower is sooner. Cheap enough to recompute for every waiting chunk whenever stale().
+    float priority(const ChunkCoord& coord) const;
+
+    // True when the view moved, turned or changed speed enough since the last mark_ranked()
+    // that priorities computed then are out of date.
+    bool stale() const;
+    void mark_ranked();
+
+    // Whether coord lies in the disc of the given radius around center. r * (r + 1) rather
+    // than r * r keeps the four axis-aligned tips from being lone chunks.
+    static bool in_disc(const ChunkCoord& coord, const ChunkCoord& center, int radius)
+    {
+        const int dx = coord.x - center.x;
+        const int dz = coord.z - center.z;
+        return dx * dx + dz * dz <= radius * (radius + 1);
+    }
+
+  private:
+    float m_prefetchSeconds;
+    float m_viewCos;
+    float m_viewBonus;
+    float m_maxLead;
+
+    glm::vec2 m_position{0.0f};
+    glm::vec2 m_forward{0.0f, -1.0f};
+    glm::vec2 m_velocity{0.0f};
+    bool m_hasPosition = false;
+
+    glm::vec2 m_rankedPosition{0.0f};
+    glm::vec2 m_rankedForward{0.0f};
+    glm::vec2 m_rankedVelocity{0.0f};
+};
+
+} // namespace world
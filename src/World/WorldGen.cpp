@@ -2,10 +2,103 @@
 
 #include "BlockRegistry.hpp"
 
-#include <glm/vec3.hpp>
+#include "Util/Hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+#include <vector>
 
 namespace world
 {
+namespace
+{
+// Identifies one set_config() call across all generators so per-thread noise never outlives
+// the configuration it was built from.
+std::atomic<std::uint64_t> nextNoiseId{1};
+
+// Caves are sampled with y scaled up so they stretch out horizontally.
+constexpr float CaveVerticalScale = 2.0f;
+
+constexpr BlockID StoneBlock = 3;
+constexpr BlockID WaterBlock = 4;
+} // namespace
+
+std::uint64_t WorldGenConfig::fingerprint() const
+{
+    std::vector<std::uint8_t> bytes;
+    const auto add = [&](auto value) {
+        const auto* raw = reinterpret_cast<const std::uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(value));
+    };
+    add(seed);
+    add(frequency);
+    add(amplitude);
+    add(octaves);
+    add(lacunarity);
+    add(gain);
+    add(baseHeight);
+    add(seaLevel);
+    add(climateFrequency);
+    add(overhangAmplitude);
+    add(overhangFrequency);
+    add(static_cast<std::uint8_t>(caves));
+    add(caveFrequency);
+    add(caveThreshold);
+    add(caveMinY);
+    add(static_cast<std::uint8_t>(legacyNestedFractal));
+    return util::fnv1a(bytes.data(), bytes.size());
+}
+
+// 3D noise sampled every StepXZ x StepY x StepXZ voxels. Lattice points are only evaluated
+// where a voxel could read them, i.e. around the surface band for overhangs and between
+// caveMinY and the surface for caves. Everything else keeps a neutral default.
+struct WorldGenerator::DensityLattice
+{
+    static constexpr int StepXZ = 4;
+    static constexpr int StepY = 8;
+    static constexpr int PointsXZ = ChunkWidth / StepXZ + 1;
+    static constexpr int PointsY = ChunkHeight / StepY + 1;
+    static constexpr int LayerPoints = PointsXZ * PointsXZ;
+
+    std::array<float, LayerPoints * PointsY> overhang{};
+    std::array<float, LayerPoints * PointsY> cave{};
+
+    static std::size_t index(int i, int k, int level)
+    {
+        return static_cast<std::size_t>(i + k * PointsXZ + level * LayerPoints);
+    }
+
+    // Linear interpolation of one field between the lattice levels around y.
+    static void layer(const std::array<float, LayerPoints * PointsY>& field, int y, std::array<float, LayerPoints>& out)
+    {
+        const int level = y / StepY;
+        const float t = static_cast<float>(y - level * StepY) / StepY;
+        for (int point = 0; point < LayerPoints; ++point)
+        {
+            const float below = field[static_cast<std::size_t>(point + level * LayerPoints)];
+            const float above = field[static_cast<std::size_t>(point + (level + 1) * LayerPoints)];
+            out[static_cast<std::size_t>(point)] = below + (above - below) * t;
+        }
+    }
+
+    // Bilinear interpolation inside an interpolated layer; with layer() this is trilinear.
+    static float at(const std::array<float, LayerPoints>& values, int x, int z)
+    {
+        const int i = x / StepXZ;
+        const int k = z / StepXZ;
+        const float fx = static_cast<float>(x - i * StepXZ) / StepXZ;
+        const float fz = static_cast<float>(z - k * StepXZ) / StepXZ;
+        const std::size_t p = static_cast<std::size_t>(i + k * PointsXZ);
+        const float top = values[p] + (values[p + 1] - values[p]) * fx;
+        const float bottom = values[p + PointsXZ] + (values[p + PointsXZ + 1] - values[p + PointsXZ]) * fx;
+        return top + (bottom - top) * fz;
+    }
+};
+
 WorldGenerator::WorldGenerator()
 {
     set_config(WorldGenConfig{});
@@ -14,86 +107,306 @@ WorldGenerator::WorldGenerator()
 void WorldGenerator::set_config(const WorldGenConfig& config)
 {
     m_config = config;
-    m_noise.SetSeed(config.seed);
-    m_noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    m_noise.SetFrequency(config.frequency);
-    m_noise.SetFractalType(FastNoiseLite::FractalType_FBm);
-    m_noise.SetFractalOctaves(config.octaves);
-    m_noise.SetFractalLacunarity(config.lacunarity);
-    m_noise.SetFractalGain(config.gain);
+    m_noiseId = nextNoiseId.fetch_add(1, std::memory_order_relaxed);
+    m_biomes.configure(config.seed, config.climateFrequency);
+}
+
+const WorldGenerator::NoiseSet& WorldGenerator::thread_noise() const
+{
+    struct ThreadNoise
+    {
+        std::uint64_t id = 0;
+        NoiseSet noise;
+    };
+    thread_local ThreadNoise state;
+
+    if (state.id != m_noiseId)
+    {
+        state.id = m_noiseId;
+        FastNoiseLite& terrain = state.noise.terrain;
+        terrain.SetSeed(m_config.seed);
+        terrain.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+        terrain.SetFrequency(m_config.frequency);
+        terrain.SetFractalType(m_config.legacyNestedFractal ? FastNoiseLite::FractalType_FBm : FastNoiseLite::FractalType_None);
+        terrain.SetFractalOctaves(m_config.octaves);
+        terrain.SetFractalLacunarity(m_config.lacunarity);
+        terrain.SetFractalGain(m_config.gain);
+
+        FastNoiseLite& overhang = state.noise.overhang;
+        overhang.SetSeed(m_config.seed + 17);
+        overhang.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+        overhang.SetFrequency(m_config.overhangFrequency);
+        overhang.SetFractalType(FastNoiseLite::FractalType_None);
+
+        FastNoiseLite& cave = state.noise.cave;
+        cave.SetSeed(m_config.seed + 31);
+        cave.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+        cave.SetFrequency(m_config.caveFrequency);
+        cave.SetFractalType(FastNoiseLite::FractalType_None);
+    }
+    return state.noise;
+}
+
+void WorldGenerator::sample_density(int originX, int originZ, const int* surfaces, DensityLattice& lattice) const
+{
+    using Lattice = DensityLattice;
+    const NoiseSet& noise = thread_noise();
+    const int reach = static_cast<int>(std::ceil(m_config.overhangAmplitude));
+
+    lattice.overhang.fill(0.0f);
+    lattice.cave.fill(-1.0f);
+
+    for (int k = 0; k < Lattice::PointsXZ; ++k)
+    {
+        for (int i = 0; i < Lattice::PointsXZ; ++i)
+        {
+            // Surface range of the columns that interpolate from this lattice point.
+            int localMin = ChunkHeight;
+            int localMax = -1;
+            for (int z = std::max(0, (k - 1) * Lattice::StepXZ); z <= std::min(ChunkDepth - 1, (k + 1) * Lattice::StepXZ); ++z)
+            {
+                for (int x = std::max(0, (i - 1) * Lattice::StepXZ); x <= std::min(ChunkWidth - 1, (i + 1) * Lattice::StepXZ); ++x)
+                {
+                    const int surface = surfaces[x + z * ChunkWidth];
+                    localMin = std::min(localMin, surface);
+                    localMax = std::max(localMax, surface);
+                }
+            }
+
+            const float worldX = static_cast<float>(originX + i * Lattice::StepXZ);
+            const float worldZ = static_cast<float>(originZ + k * Lattice::StepXZ);
+            const auto levels = [](int low, int high) {
+                return std::pair{std::clamp(low / Lattice::StepY, 0, Lattice::PointsY - 1),
+                                 std::clamp(high / Lattice::StepY + 1, 0, Lattice::PointsY - 1)};
+            };
+
+            if (reach > 0)
+            {
+                const auto [first, last] = levels(std::max(0, localMin - reach), localMax + reach);
+                for (int level = first; level <= last; ++level)
+                {
+                    const float worldY = static_cast<float>(level * Lattice::StepY);
+                    lattice.overhang[Lattice::index(i, k, level)] = noise.overhang.GetNoise(worldX, worldY, worldZ);
+                }
+            }
+
+            // Caves stay at least four blocks under the surface.
+            if (m_config.caves && localMax - 5 >= m_config.caveMinY)
+            {
+                const auto [first, last] = levels(m_config.caveMinY, localMax - 5);
+                for (int level = first; level <= last; ++level)
+                {
+                    const float worldY = static_cast<float>(level * Lattice::StepY) * CaveVerticalScale;
+                    lattice.cave[Lattice::index(i, k, level)] = noise.cave.GetNoise(worldX, worldY, worldZ);
+                }
+            }
+        }
+    }
 }
 
 void WorldGenerator::generate_chunk(Chunk& chunk) const
 {
-    const glm::vec3 origin = chunk.world_position();
+    using Lattice = DensityLattice;
+    const ChunkCoord coord = chunk.coord();
 
     // Height is computed via fractal noise; amplitude, frequency and octave controls are
     // exposed through WorldGenConfig so designers can easily tune the terrain profile.
-    for (int x = 0; x < ChunkWidth; ++x)
+    std::array<float, SectionLayerArea> heights{};
+    std::array<int, SectionLayerArea> surfaces{};
+    height_map(coord.x * ChunkWidth, coord.z * ChunkDepth, ChunkWidth, ChunkDepth, heights.data());
+
+    // Biomes come from the shared region cache; a chunk never straddles two regions.
+    std::array<ClimateSample, SectionLayerArea> climate{};
+    m_biomes.sample(coord.x * ChunkWidth, coord.z * ChunkDepth, ChunkWidth, ChunkDepth, climate.data());
+
+    int minSurface = ChunkHeight;
+    int maxSurface = -1;
+    for (std::size_t column = 0; column < heights.size(); ++column)
     {
-        for (int z = 0; z < ChunkDepth; ++z)
+        surfaces[column] = static_cast<int>(heights[column]);
+        minSurface = std::min(minSurface, surfaces[column]);
+        maxSurface = std::max(maxSurface, surfaces[column]);
+    }
+
+    Lattice lattice;
+    sample_density(coord.x * ChunkWidth, coord.z * ChunkDepth, surfaces.data(), lattice);
+
+    // Density is solid when (surface + 0.5 - y) + overhangAmplitude * overhang noise > 0, so
+    // the surface only moves inside a band of +-reach blocks. Below that band and caveMinY
+    // every voxel is plain stone.
+    const float amplitude = m_config.overhangAmplitude;
+    const int reach = static_cast<int>(std::ceil(amplitude));
+    int stoneBelow = minSurface - reach - 3;
+    if (m_config.caves)
+        stoneBelow = std::min(stoneBelow, m_config.caveMinY);
+    stoneBelow = std::clamp(stoneBelow, 0, ChunkHeight);
+    const int top = std::min(ChunkHeight - 1, std::max(maxSurface + reach, static_cast<int>(std::ceil(m_config.seaLevel)) - 1));
+
+    // Layers are written top-down a 16x16 layer at a time so the SIMD copy/fill kernels apply.
+    // depth counts solid voxels since the last open air above each column and picks surface,
+    // subsurface or stone; cave air does not reset it, so cave floors stay stone. Everything
+    // above the top is left as the section's default air.
+    std::array<BlockID, SectionLayerArea> layer{};
+    std::array<int, SectionLayerArea> depth{};
+    std::array<float, Lattice::LayerPoints> overhangLayer{};
+    std::array<float, Lattice::LayerPoints> caveLayer{};
+    for (int y = top; y >= stoneBelow; --y)
+    {
+        if (reach > 0)
+            Lattice::layer(lattice.overhang, y, overhangLayer);
+
+        // Trilinear values never exceed their lattice corners, so one check rules out caves
+        // for the whole layer.
+        bool layerCaves = false;
+        if (m_config.caves && y >= m_config.caveMinY)
         {
-            const float worldX = origin.x + static_cast<float>(x);
-            const float worldZ = origin.z + static_cast<float>(z);
-            const float height = noise_height(worldX, worldZ);
-            const int surfaceY = static_cast<int>(height);
+            Lattice::layer(lattice.cave, y, caveLayer);
+            layerCaves = *std::max_element(caveLayer.begin(), caveLayer.end()) > m_config.caveThreshold;
+        }
 
-            for (int y = 0; y < ChunkHeight; ++y)
+        for (int z = 0; z < ChunkDepth; ++z)
+        {
+            for (int x = 0; x < ChunkWidth; ++x)
             {
+                const std::size_t column = static_cast<std::size_t>(x + z * ChunkWidth);
+                const int surfaceY = surfaces[column];
+
+                bool solid = y <= surfaceY;
+                if (reach > 0 && std::abs(y - surfaceY) <= reach)
+                {
+                    const float density = static_cast<float>(surfaceY - y) + 0.5f + amplitude * Lattice::at(overhangLayer, x, z);
+                    solid = density > 0.0f;
+                }
+
+                const bool cave = solid && layerCaves && y < surfaceY - 4 && Lattice::at(caveLayer, x, z) > m_config.caveThreshold;
+
                 BlockID block = BlockAir;
-                if (y <= surfaceY)
+                if (solid && !cave)
                 {
-                    if (y == surfaceY)
-                    {
-                        block = surface_block(height, static_cast<float>(y));
-                    }
-                    else if (y > surfaceY - 4)
-                    {
-                        block = 2; // dirt
-                    }
+                    const int d = depth[column]++;
+                    if (d == 0)
+                        block = surface_block(heights[column], static_cast<float>(y), climate[column].biome);
+                    else if (d < 4)
+                        block = subsurface_block(climate[column].biome);
                     else
-                    {
-                        block = 3; // stone
-                    }
+                        block = StoneBlock;
                 }
-                else if (static_cast<float>(y) < m_config.seaLevel)
+                else if (!solid)
                 {
-                    block = 4; // water
+                    depth[column] = 0;
+                    if (static_cast<float>(y) < m_config.seaLevel)
+                        block = WaterBlock;
                 }
+                layer[column] = block;
+            }
+        }
+        chunk.set_layer(y, layer.data());
+    }
 
-                chunk.set(x, y, z, block);
+    // Solid stone below: partial section layers first, then whole sections in one go.
+    layer.fill(StoneBlock);
+    for (int y = stoneBelow - 1; y >= 0; --y)
+    {
+        if (y % SectionSize == SectionSize - 1)
+        {
+            for (int section = y / SectionSize; section >= 0; --section)
+            {
+                chunk.fill_section(section, StoneBlock);
             }
+            break;
         }
+        chunk.set_layer(y, layer.data());
     }
 }
 
-float WorldGenerator::noise_height(float x, float z) const
+// Octaves run over the whole block in turn: the sample coordinates of a row are scaled once
+// per octave and the weighted sums accumulate in tight loops over contiguous floats. The sum
+// order matches the former per-column evaluation, so legacy mode reproduces it bit for bit.
+void WorldGenerator::height_map(int originX, int originZ, int width, int depth, float* heights, int step) const
 {
-    float amplitude = m_config.amplitude;
-    float value = 0.0f;
+    const FastNoiseLite& noise = thread_noise().terrain;
+    const std::size_t count = static_cast<std::size_t>(width) * static_cast<std::size_t>(depth);
+    std::fill(heights, heights + count, 0.0f);
+
+    // Per-thread scratch: this runs for every chunk and far terrain tile, and after the first
+    // few calls the buffer is already big enough.
+    thread_local std::vector<float> sampleX;
+    sampleX.resize(static_cast<std::size_t>(width));
     float frequency = m_config.frequency;
     float weight = 1.0f;
-    for (int i = 0; i < m_config.octaves; ++i)
+    for (int octave = 0; octave < m_config.octaves; ++octave)
     {
-        value += m_noise.GetNoise(x * frequency, z * frequency) * amplitude * weight;
+        for (int x = 0; x < width; ++x)
+        {
+            sampleX[static_cast<std::size_t>(x)] = static_cast<float>(originX + x * step) * frequency;
+        }
+
+        for (int z = 0; z < depth; ++z)
+        {
+            const float sampleZ = static_cast<float>(originZ + z * step) * frequency;
+            float* row = heights + static_cast<std::size_t>(z) * static_cast<std::size_t>(width);
+            for (int x = 0; x < width; ++x)
+            {
+                row[x] += noise.GetNoise(sampleX[static_cast<std::size_t>(x)], sampleZ) * m_config.amplitude * weight;
+            }
+        }
+
         weight *= m_config.gain;
         frequency *= m_config.lacunarity;
     }
-    return m_config.baseHeight + value;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        heights[i] += m_config.baseHeight;
+    }
+}
+
+void WorldGenerator::climate(int originX, int originZ, int width, int depth, ClimateSample* out, int step) const
+{
+    m_biomes.sample(originX, originZ, width, depth, out, step);
+}
+
+void WorldGenerator::surface_map(int originX, int originZ, int width, int depth, SurfaceSample* out, int step) const
+{
+    const std::size_t count = static_cast<std::size_t>(width) * static_cast<std::size_t>(depth);
+    std::vector<float> heights(count);
+    std::vector<ClimateSample> climate(count);
+    height_map(originX, originZ, width, depth, heights.data(), step);
+    m_biomes.sample(originX, originZ, width, depth, climate.data(), step);
+
+    // Water fills every voxel below seaLevel, so its top face sits at the first whole y above.
+    const float waterTop = std::ceil(m_config.seaLevel);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float surfaceY = std::floor(heights[i]);
+        if (surfaceY + 1.0f < waterTop)
+            out[i] = {waterTop, WaterBlock};
+        else
+            out[i] = {surfaceY + 1.0f, surface_block(heights[i], surfaceY, climate[i].biome)};
+    }
 }
 
-BlockID WorldGenerator::surface_block(float height, float y) const
+BlockID WorldGenerator::surface_block(float height, float y, Biome biome) const
 {
     const float normalized = height - m_config.baseHeight;
     if (y < m_config.seaLevel - 2.0f)
     {
         return 5; // sand
     }
-    if (normalized > 40.0f)
+    if (normalized > 40.0f || biome == Biome::Tundra)
     {
         return 6; // snow
     }
+    if (biome == Biome::Desert)
+    {
+        return 5; // sand
+    }
     return 1; // grass
 }
 
+BlockID WorldGenerator::subsurface_block(Biome biome) const
+{
+    return biome == Biome::Desert ? 5 : 2; // sand : dirt
+}
+
 } // namespace world
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BiomeMap.hpp"
 #include "Chunk.hpp"
 #include "Config.hpp"
 
@@ -17,6 +18,25 @@ struct WorldGenConfig
     float gain = config::noise().gain;
     float baseHeight = config::noise().baseHeight;
     float seaLevel = config::noise().seaLevel;
+    float climateFrequency = config::noise().climateFrequency;
+    float overhangAmplitude = config::noise().overhangAmplitude;
+    float overhangFrequency = config::noise().overhangFrequency;
+    bool caves = config::noise().caves;
+    float caveFrequency = config::noise().caveFrequency;
+    float caveThreshold = config::noise().caveThreshold;
+    int caveMinY = config::noise().caveMinY;
+    bool legacyNestedFractal = config::noise().legacyNestedFractal;
+
+    // Hash of every field that shapes the terrain; stored chunks are only reused under an
+    // identical config.
+    std::uint64_t fingerprint() const;
+};
+
+// Terrain as seen from far away: the top of the column and the block on top of it.
+struct SurfaceSample
+{
+    float height = 0.0f; // world y of the top face
+    BlockID block = BlockAir;
 };
 
 class WorldGenerator
@@ -27,12 +47,38 @@ class WorldGenerator
     void set_config(const WorldGenConfig& config);
     void generate_chunk(Chunk& chunk) const;
 
+    // Terrain heights for a width x depth grid of columns starting at world column
+    // (originX, originZ) and spaced step columns apart, written row-major with x fastest.
+    // Safe to call from many threads.
+    void height_map(int originX, int originZ, int width, int depth, float* heights, int step = 1) const;
+
+    // Climate and biome per column, same layout as height_map.
+    void climate(int originX, int originZ, int width, int depth, ClimateSample* out, int step = 1) const;
+
+    // Heightmap-only surface for distant terrain, same layout as height_map. Overhangs, caves
+    // and decorations are skipped, and water is reported as its surface at sea level.
+    void surface_map(int originX, int originZ, int width, int depth, SurfaceSample* out, int step = 1) const;
+
+    const WorldGenConfig& config() const { return m_config; }
+
   private:
-    float noise_height(float x, float z) const;
-    BlockID surface_block(float height, float y) const;
+    struct NoiseSet
+    {
+        FastNoiseLite terrain;
+        FastNoiseLite overhang;
+        FastNoiseLite cave;
+    };
+    struct DensityLattice;
+
+    // Each thread samples through its own noise objects, rebuilt whenever set_config runs.
+    const NoiseSet& thread_noise() const;
+    void sample_density(int originX, int originZ, const int* surfaces, DensityLattice& lattice) const;
+    BlockID surface_block(float height, float y, Biome biome) const;
+    BlockID subsurface_block(Biome biome) const;
 
     WorldGenConfig m_config;
-    mutable FastNoiseLite m_noise;
+    std::uint64_t m_noiseId = 0;
+    BiomeMap m_biomes;
 };
 
 } // namespace world
@@ -1,13 +1,15 @@
 #include "WorldStreamer.hpp"
 
 #include "BlockRegistry.hpp"
+#include "ChunkCodec.hpp"
+#include "Decorator.hpp"
+#include "Core/Timer.hpp"
 #include "Util/Logging.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cmath>
-#include <queue>
-#include <unordered_map>
+#include <limits>
 
 #include <glm/vec3.hpp>
 
@@ -15,250 +17,1392 @@ namespace world
 {
 namespace
 {
-std::vector<ChunkCoord> chunk_offsets(int radius)
+// Half the height of the load disc's column at offset dx from its center.
+int disc_half_extent(int dx, int radius)
 {
-    std::vector<ChunkCoord> coords;
-    for (int dx = -radius; dx <= radius; ++dx)
+    const int remaining = radius * (radius + 1) - dx * dx;
+    return remaining < 0 ? -1 : static_cast<int>(std::sqrt(static_cast<float>(remaining)));
+}
+
+// Appends the coordinates in the disc of `radius` around `center` (see StreamingView::in_disc)
+// that are not in the disc around `previous`. Each column of the new disc is one interval of
+// rows and the old disc removes at most one interval from it, so the work is proportional to
+// the strip that changed rather than to the disc.
+void disc_difference(const ChunkCoord& center, const std::optional<ChunkCoord>& previous, int radius, std::vector<ChunkCoord>& out)
+{
+    for (int x = center.x - radius; x <= center.x + radius; ++x)
     {
-        for (int dz = -radius; dz <= radius; ++dz)
+        const int half = disc_half_extent(x - center.x, radius);
+        const int first = center.z - half;
+        const int last = center.z + half;
+        const int previousHalf = previous ? disc_half_extent(x - previous->x, radius) : -1;
+        if (previousHalf < 0)
+        {
+            for (int z = first; z <= last; ++z)
+            {
+                out.push_back({x, z});
+            }
+            continue;
+        }
+        for (int z = first; z <= std::min(last, previous->z - previousHalf - 1); ++z)
+        {
+            out.push_back({x, z});
+        }
+        for (int z = std::max(first, previous->z + previousHalf + 1); z <= last; ++z)
         {
-            coords.push_back({dx, dz});
+            out.push_back({x, z});
         }
     }
-    std::sort(coords.begin(), coords.end(), [](const ChunkCoord& a, const ChunkCoord& b) {
-        const int da = std::abs(a.x) + std::abs(a.z);
-        const int db = std::abs(b.x) + std::abs(b.z);
-        return da < db;
-    });
-    return coords;
 }
 
-const std::vector<ChunkCoord>& load_order(int radius)
+// The border strip of coord's mesh that faces the adjacent chunk `other`.
+MeshPart facing_border(const ChunkCoord& coord, const ChunkCoord& other)
+{
+    if (other.x != coord.x)
+        return other.x > coord.x ? MeshPart::PosX : MeshPart::NegX;
+    return other.z > coord.z ? MeshPart::PosZ : MeshPart::NegZ;
+}
+
+std::vector<ChunkCoord> side_neighbors(const ChunkCoord& coord)
 {
-    static std::unordered_map<int, std::vector<ChunkCoord>> cache;
-    auto it = cache.find(radius);
-    if (it != cache.end())
-        return it->second;
-    auto [emplaced, inserted] = cache.emplace(radius, chunk_offsets(radius));
-    return emplaced->second;
+    return {{coord.x + 1, coord.z}, {coord.x - 1, coord.z}, {coord.x, coord.z + 1}, {coord.x, coord.z - 1}};
+}
+
+// Back to the all-air state of a fresh chunk after a failed decode.
+void clear_chunk(Chunk& chunk)
+{
+    for (int index = 0; index < SectionCount; ++index)
+    {
+        chunk.fill_section(index, BlockAir);
+    }
 }
 
 } // namespace
 
-WorldStreamer::WorldStreamer()
-    : m_generationJobs(std::thread::hardware_concurrency())
+WorldStreamer::WorldStreamer(renderer::MeshFactory* meshes)
+    : m_meshes(meshes)
+    , m_light([this](const ChunkCoord& coord) -> Chunk* {
+        ChunkEntry* entry = find_entry(coord);
+        return entry && entry->chunk->lit() ? entry->chunk.get() : nullptr;
+    })
+    , m_farTerrain(m_generator, meshes)
+    , m_chunks(m_epochs)
+    , m_warmCache(config::streaming().warmCacheBytes)
+    // Enough queued work to keep every worker busy while the main thread is between frames,
+    // little enough that a re-ranked backlog takes effect within a few jobs.
+    , m_generationSlots(2 * static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)))
+    , m_budget(config::memory())
     , m_meshingJobs(std::thread::hardware_concurrency())
+    , m_generationJobs(std::thread::hardware_concurrency())
 {
+    const char* directory = config::streaming().worldDirectory;
+    if (directory && *directory)
+        m_regions = std::make_unique<RegionStore>(directory, m_generator.config().fingerprint());
 }
 
-void WorldStreamer::reload()
+// Runs before any member is destroyed, so workers may still be finishing jobs: they no longer
+// change blocks (only the main thread edits, and chunks still generating are skipped), and
+// the light they may touch is not stored. Compress jobs that never get to run are covered by
+// take_unsaved(). The region store finishes its queue when it is destroyed after the workers.
+WorldStreamer::~WorldStreamer()
 {
-    std::unique_lock lock(m_chunkMutex);
-    for (auto& [coord, entry] : m_chunks)
+    if (!m_regions)
+        return;
+
+    m_chunks.for_each([this](const ChunkEntry& entry) {
+        if (entry.chunk->state() != ChunkState::Generating && entry.unsaved)
+        {
+            std::vector<std::uint8_t> record;
+            ChunkCodec::encode_record(*entry.chunk, false, entry.decorations, record);
+            m_regions->save(entry.coord(), std::move(record));
+        }
+        else if (entry.chunk->state() == ChunkState::Generating && entry.cached && entry.cached->unsaved)
+        {
+            m_regions->save(entry.coord(), entry.cached->record);
+        }
+    });
+    for (const auto& [coord, cached] : m_warmCache.take_unsaved())
     {
-        entry->chunk->mark_dirty(0);
-        entry->chunk->mark_dirty(1);
-        entry->chunk->mark_dirty(2);
-        schedule_meshing(entry);
+        m_regions->save(coord, cached->record);
     }
 }
 
-std::shared_ptr<WorldStreamer::ChunkEntry> WorldStreamer::ensure_chunk(const ChunkCoord& coord)
+void WorldStreamer::reload()
 {
-    std::unique_lock lock(m_chunkMutex);
-    auto it = m_chunks.find(coord);
-    if (it != m_chunks.end())
+    m_chunks.for_each([this](ChunkEntry& entry) {
+        invalidate_mesh(entry);
+        schedule_meshing(entry);
+    });
+}
+
+WorldStreamer::ChunkEntry* WorldStreamer::ensure_chunk(const ChunkCoord& coord)
+{
+    if (ChunkEntry* existing = m_chunks.find(coord))
     {
-        return it->second;
+        return existing;
     }
 
-    auto entry = std::make_shared<ChunkEntry>();
+    auto entry = std::make_unique<ChunkEntry>();
     entry->chunk = std::make_shared<Chunk>(coord);
-    m_chunks.emplace(coord, entry);
     entry->chunk->set_state(ChunkState::Generating);
-    lock.unlock();
+    entry->cached = m_warmCache.take(coord);
+    entry->id = m_chunks.next_handle(coord);
+    ChunkEntry* stored = m_chunks.store(coord, std::move(entry));
 
-    schedule_generation(entry);
-    return entry;
+    // Generation waits in the backlog until dispatch_generation picks it by priority.
+    m_generationBacklog.push_back({stored->id, coord, priority(coord)});
+    m_backlogSorted = false;
+    return stored;
 }
 
-std::shared_ptr<WorldStreamer::ChunkEntry> WorldStreamer::find_entry(const ChunkCoord& coord) const
+WorldStreamer::ChunkEntry* WorldStreamer::find_entry(const ChunkCoord& coord) const
 {
-    std::shared_lock lock(m_chunkMutex);
-    auto it = m_chunks.find(coord);
-    if (it != m_chunks.end())
-    {
-        return it->second;
-    }
-    return nullptr;
+    return m_chunks.find(coord);
 }
 
-void WorldStreamer::schedule_generation(const std::shared_ptr<ChunkEntry>& entry)
+// Generation runs as a staged pipeline of jobs. The first job writes terrain and computes the
+// chunk's decoration writes; decoration only reads the chunk's own terrain, so both stages
+// share it. Finalize needs every neighbour decorated, because their features may reach into
+// this chunk. Instead of waiting, a chunk is offered to try_finalize whenever it or one of
+// its neighbours finishes decorating, and the job is queued once the whole ring is ready.
+//
+// Jobs name their entry by handle and resolve it under an epoch guard, which keeps the entry
+// and every neighbour they look up alive until the job returns.
+void WorldStreamer::schedule_generation(ChunkEntry& entry)
 {
-    auto weakEntry = std::weak_ptr<ChunkEntry>(entry);
-    m_generationJobs.enqueue([this, weakEntry]() {
-        if (auto strong = weakEntry.lock())
+    m_generationInFlight.fetch_add(1, std::memory_order_relaxed);
+    m_generationJobs.enqueue([this, handle = entry.id]() {
+        core::EpochGuard guard(m_epochs);
+        // A chunk unloaded before or during the job stops at the next stage boundary.
+        ChunkEntry* strong = m_chunks.resolve(handle);
+        bool restored = false;
+        if (strong && !strong->cancelled)
+        {
+            // Warm cache, then region files, then the generator.
+            restored = (strong->cached && restore_chunk(*strong)) || load_chunk(*strong);
+            if (!restored)
+            {
+                m_generator.generate_chunk(*strong->chunk);
+                strong->chunk->set_stage(GenerationStage::Terrain);
+                strong->unsaved = true;
+            }
+        }
+        if (!strong || strong->cancelled)
+        {
+            m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+            m_generationInFlight.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const ChunkCoord coord = strong->chunk->coord();
+        if (restored)
         {
-            m_generator.generate_chunk(*strong->chunk);
+            // Restored chunks skip their own finalize: lighting them against the current
+            // neighbours is all that is left, and it makes their borders visible next door.
+            std::vector<ChunkCoord> touched;
+            std::vector<LitBorder> litBorders;
+            m_light.light_chunk(strong->chunk, touched, litBorders);
+            strong->chunk->set_stage(GenerationStage::Finalized);
             strong->chunk->set_state(ChunkState::MeshPending);
-            strong->chunk->mark_dirty(0);
-            strong->chunk->mark_dirty(1);
-            strong->chunk->mark_dirty(2);
+            invalidate_mesh(*strong);
+            remesh_chunks(touched, false);
+            remesh_borders(coord, side_neighbors(coord), touched, false);
+            remesh_lit_borders(litBorders, touched, false);
+            schedule_meshing(*strong);
+        }
+        else
+        {
+            Decorator::decorate(*strong->chunk, m_generator, strong->decorations);
+            strong->chunk->set_stage(GenerationStage::Decorated);
+        }
 
-            const ChunkCoord coord = strong->chunk->coord();
-            const std::array<ChunkCoord, 4> neighborOffsets = {{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
-            for (const auto& offset : neighborOffsets)
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
             {
-                if (auto neighbor = find_entry({coord.x + offset.x, coord.z + offset.z}))
-                {
-                    neighbor->chunk->mark_dirty(0);
-                    neighbor->chunk->mark_dirty(1);
-                    neighbor->chunk->mark_dirty(2);
-                    schedule_meshing(neighbor);
-                }
+                if (ChunkEntry* candidate = (dx == 0 && dz == 0) ? strong : find_entry({coord.x + dx, coord.z + dz}))
+                    try_finalize(*candidate);
             }
+        }
+        m_generationInFlight.fetch_sub(1, std::memory_order_relaxed);
+    });
+}
+
+// Fills a fresh chunk from its warm cache payload; the decoration writes come along so
+// neighbours generated since can still finalize against it.
+bool WorldStreamer::restore_chunk(ChunkEntry& entry)
+{
+    const CachedChunk& cached = *entry.cached;
+    if (!ChunkCodec::decode_record(cached.record.data(), cached.record.size(), *entry.chunk, entry.decorations))
+    {
+        const ChunkCoord coord = entry.chunk->coord();
+        util::log().error("Cached chunk (%d, %d) failed to decode; generating it again", coord.x, coord.z);
+        clear_chunk(*entry.chunk);
+        return false;
+    }
+    entry.unsaved = cached.unsaved;
+    return true;
+}
+
+// Same as restore_chunk, from the region files. Stored light (the pregeneration tool keeps
+// it) is dropped: the chunk is lit against its current neighbours like any restored chunk.
+bool WorldStreamer::load_chunk(ChunkEntry& entry)
+{
+    if (!m_regions)
+        return false;
+
+    bool malformed = false;
+    const bool loaded = m_regions->load(entry.chunk->coord(), [&](const std::uint8_t* data, std::size_t size) {
+        malformed = !ChunkCodec::decode_record(data, size, *entry.chunk, entry.decorations);
+        return !malformed;
+    });
+    if (malformed)
+    {
+        const ChunkCoord coord = entry.chunk->coord();
+        util::log().error("Stored chunk (%d, %d) failed to decode; generating it again", coord.x, coord.z);
+        clear_chunk(*entry.chunk);
+        entry.decorations.clear();
+    }
+    if (!loaded)
+        return false;
+
+    entry.chunk->set_lit(false);
+    m_loadedChunks.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// The backlog is sorted worst first so the best chunk pops off the back. Entries whose chunk
+// was unloaded while waiting no longer resolve and are never generated.
+void WorldStreamer::dispatch_generation()
+{
+    const bool stale = m_observersChanged || std::any_of(m_observers.begin(), m_observers.end(), [](const Observer& observer) {
+        return observer.view.stale();
+    });
+    if (stale)
+    {
+        for (auto& waiting : m_generationBacklog)
+        {
+            waiting.priority = priority(waiting.coord);
+        }
+        for (auto& observer : m_observers)
+        {
+            observer.view.mark_ranked();
+        }
+        m_observersChanged = false;
+        m_backlogSorted = false;
+    }
+    if (!m_backlogSorted)
+    {
+        std::sort(m_generationBacklog.begin(), m_generationBacklog.end(), [](const WaitingChunk& a, const WaitingChunk& b) {
+            return a.priority > b.priority;
+        });
+        m_backlogSorted = true;
+    }
+
+    // Voxel data is the one category that cannot be rebuilt on demand. Past its cap the nearest
+    // waiting chunk goes first rather than the best ranked one, and only once chunks farther out
+    // make room for it (see evict_farther_than); when none is left, the loaded area stops
+    // growing until others unload.
+    std::vector<ChunkCoord> evicted;
+    std::vector<std::pair<int, ChunkEntry*>> farthest;
+    while (!m_generationBacklog.empty() && m_generationInFlight.load(std::memory_order_relaxed) < m_generationSlots)
+    {
+        auto next = m_generationBacklog.end() - 1;
+        ChunkEntry* entry = nullptr;
+        if (m_budget.over(MemoryCategory::Voxels))
+        {
+            next = std::min_element(m_generationBacklog.begin(), m_generationBacklog.end(), [this](const WaitingChunk& a, const WaitingChunk& b) {
+                return observer_distance(a.coord) < observer_distance(b.coord);
+            });
+            entry = m_chunks.resolve(next->entry);
+            // One chunk of slack keeps the waiting chunk's own neighbours, which it needs to
+            // finalize, from being evicted to make room for it.
+            if (entry && !evict_farther_than(observer_distance(next->coord) + 1, farthest, evicted))
+                break;
+        }
+        else
+        {
+            entry = m_chunks.resolve(next->entry);
+        }
+        m_generationBacklog.erase(next);
+        if (entry)
+            schedule_generation(*entry);
+    }
+
+    // Evicted chunks still inside a load radius wait in the backlog to come back from the warm
+    // cache; they are farther than anything loaded in their place, so they rank behind it.
+    for (const ChunkCoord& coord : evicted)
+    {
+        const bool wanted = std::any_of(m_observers.begin(), m_observers.end(), [&](const Observer& observer) {
+            return observer.center && StreamingView::in_disc(coord, *observer.center, observer.loadRadius);
+        });
+        if (wanted)
+            ensure_chunk(coord);
+    }
+}
+
+// Unloads chunks holding voxel data farther than `distance` from every observer, farthest
+// first, until the voxel data is back under its cap. Finished chunks go to the warm cache;
+// partly generated ones, often stuck waiting for neighbours that cannot load, are dropped and
+// generated again later. `farthest` is filled on first use and shared by the calls of one
+// dispatch_generation. Returns false if nothing far enough was left.
+bool WorldStreamer::evict_farther_than(int distance, std::vector<std::pair<int, ChunkEntry*>>& farthest, std::vector<ChunkCoord>& evicted)
+{
+    if (farthest.empty() && evicted.empty())
+    {
+        m_chunks.for_each([&](ChunkEntry& entry) {
+            if (entry.chunk->state() != ChunkState::Generating || entry.chunk->stage() != GenerationStage::None)
+                farthest.emplace_back(observer_distance(entry.coord()), &entry);
+        });
+        // Nearest first, so the farthest pops off the back.
+        std::sort(farthest.begin(), farthest.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    while (m_budget.over(MemoryCategory::Voxels))
+    {
+        if (farthest.empty() || farthest.back().first <= distance)
+            return false;
+        const ChunkCoord coord = farthest.back().second->coord();
+        const std::size_t freed = static_cast<std::size_t>(farthest.back().second->chunk->allocated_sections()) * ChunkSection::StorageBytes;
+        farthest.pop_back();
+        unload_chunks({coord});
+        evicted.push_back(coord);
+        ++m_evictedChunks;
+        m_budget.set_used(MemoryCategory::Voxels, m_budget.used(MemoryCategory::Voxels) - std::min(freed, m_budget.used(MemoryCategory::Voxels)));
+    }
+    return true;
+}
+
+bool WorldStreamer::gather_decorated_ring(const ChunkCoord& coord, RingRefs& ring) const
+{
+    std::size_t slot = 0;
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            if (dx == 0 && dz == 0)
+                continue;
+            ChunkEntry* neighbor = find_entry({coord.x + dx, coord.z + dz});
+            if (!neighbor || neighbor->chunk->stage() < GenerationStage::Decorated)
+                return false;
+            ring[slot++] = neighbor;
+        }
+    }
+    return true;
+}
+
+void WorldStreamer::try_finalize(ChunkEntry& entry)
+{
+    if (entry.chunk->stage() != GenerationStage::Decorated)
+        return;
+
+    RingRefs ring;
+    if (!gather_decorated_ring(entry.chunk->coord(), ring) || entry.finalizeQueued.exchange(true))
+        return;
+
+    m_generationJobs.enqueue([this, handle = entry.id]() {
+        core::EpochGuard guard(m_epochs);
+        ChunkEntry* strong = m_chunks.resolve(handle);
+        if (!strong || strong->cancelled)
+        {
+            m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const ChunkCoord coord = strong->chunk->coord();
+        RingRefs ring;
+        if (!gather_decorated_ring(coord, ring))
+        {
+            // A neighbour was unloaded since the check; it retries this chunk once it is back.
+            strong->finalizeQueued = false;
+            return;
+        }
 
-            schedule_meshing(strong);
+        // Decoration writes are applied by the chunk that owns the blocks, from its own
+        // features and from any neighbour feature that crosses the border.
+        Decorator::apply(*strong->chunk, strong->decorations);
+        for (const ChunkEntry* neighbor : ring)
+        {
+            Decorator::apply(*strong->chunk, neighbor->decorations);
         }
+
+        // Neighbours see the new chunk's border blocks and any light that flowed into them:
+        // chunks whose light changed are remeshed, the other neighbours only rebuild the strip
+        // along the shared border, and so do the chunks next to a touched chunk's border.
+        std::vector<ChunkCoord> touched;
+        std::vector<LitBorder> litBorders;
+        m_light.light_chunk(strong->chunk, touched, litBorders);
+
+        strong->chunk->set_stage(GenerationStage::Finalized);
+        strong->chunk->set_state(ChunkState::MeshPending);
+        invalidate_mesh(*strong);
+
+        remesh_chunks(touched, false);
+        remesh_borders(coord, side_neighbors(coord), touched, false);
+        remesh_lit_borders(litBorders, touched, false);
+        schedule_meshing(*strong);
     });
 }
 
 NeighborSet WorldStreamer::gather_neighbors(const ChunkCoord& coord) const
 {
     NeighborSet neighbors;
-    if (auto entry = find_entry({coord.x + 1, coord.z}))
+    if (const ChunkEntry* entry = find_entry({coord.x + 1, coord.z}))
         neighbors.posX = entry->chunk.get();
-    if (auto entry = find_entry({coord.x - 1, coord.z}))
+    if (const ChunkEntry* entry = find_entry({coord.x - 1, coord.z}))
         neighbors.negX = entry->chunk.get();
-    if (auto entry = find_entry({coord.x, coord.z + 1}))
+    if (const ChunkEntry* entry = find_entry({coord.x, coord.z + 1}))
         neighbors.posZ = entry->chunk.get();
-    if (auto entry = find_entry({coord.x, coord.z - 1}))
+    if (const ChunkEntry* entry = find_entry({coord.x, coord.z - 1}))
         neighbors.negZ = entry->chunk.get();
     return neighbors;
 }
 
-void WorldStreamer::schedule_meshing(const std::shared_ptr<ChunkEntry>& entry)
+void WorldStreamer::remesh_chunks(const std::vector<ChunkCoord>& coords, bool edited)
+{
+    for (const ChunkCoord& coord : coords)
+    {
+        if (ChunkEntry* entry = find_entry(coord))
+        {
+            invalidate_mesh(*entry);
+            if (edited)
+                entry->edited = true;
+            schedule_meshing(*entry);
+        }
+    }
+}
+
+// Only the strip of each neighbour's mesh along its border with `changed` is rebuilt; neighbours
+// in `remeshed` are rebuilt whole anyway.
+void WorldStreamer::remesh_borders(const ChunkCoord& changed, const std::vector<ChunkCoord>& neighbors, const std::vector<ChunkCoord>& remeshed, bool edited)
+{
+    for (const ChunkCoord& coord : neighbors)
+    {
+        if (std::find(remeshed.begin(), remeshed.end(), coord) != remeshed.end())
+            continue;
+        if (ChunkEntry* entry = find_entry(coord))
+        {
+            entry->dirtyBorders.fetch_or(part_bit(facing_border(coord, changed)));
+            if (edited)
+                entry->edited = true;
+            schedule_meshing(*entry);
+        }
+    }
+}
+
+// Light that changed on a border is sampled by the faces across it, so the neighbour rebuilds
+// the strip facing the chunk it changed in.
+void WorldStreamer::remesh_lit_borders(const std::vector<LitBorder>& borders, const std::vector<ChunkCoord>& remeshed, bool edited)
+{
+    for (const LitBorder& border : borders)
+    {
+        remesh_borders(border.changed, {border.neighbor}, remeshed, edited);
+    }
+}
+
+bool WorldStreamer::is_urgent(const ChunkCoord& coord) const
+{
+    const int radius = config::streaming().urgentMeshRadius;
+    return std::any_of(m_observers.begin(), m_observers.end(), [&](const Observer& observer) {
+        return observer.center && std::max(std::abs(coord.x - observer.center->x), std::abs(coord.z - observer.center->z)) <= radius;
+    });
+}
+
+bool WorldStreamer::in_render_area(const ChunkCoord& coord)
+{
+    const Observer* camera = m_cameraObserver ? find_observer(*m_cameraObserver) : nullptr;
+    return camera && camera->center && StreamingView::in_disc(coord, *camera->center, config::streaming().renderRadius);
+}
+
+// A chunk wanted by several observers is ranked for the nearest of them; it is still only
+// one entry, generated and meshed once.
+float WorldStreamer::priority(const ChunkCoord& coord) const
+{
+    float best = std::numeric_limits<float>::max();
+    for (const Observer& observer : m_observers)
+    {
+        best = std::min(best, observer.view.priority(coord));
+    }
+    return best;
+}
+
+// meshInFlight covers a chunk from its mesh request until the result is received, so requests
+// in between fold into the one already made. Chunks still generating are meshed once they
+// finalize, and edits go straight to the workers; everything else waits for dispatch_meshing.
+void WorldStreamer::schedule_meshing(ChunkEntry& entry)
 {
-    if (entry->meshInFlight.exchange(true))
+    if (entry.chunk->state() == ChunkState::Generating || entry.meshInFlight.exchange(true))
+        return;
+
+    if (entry.edited.exchange(false))
     {
+        schedule_split_meshing(entry);
         return;
     }
 
-    auto weakEntry = std::weak_ptr<ChunkEntry>(entry);
-    m_meshingJobs.enqueue([this, weakEntry]() {
-        if (auto strong = weakEntry.lock())
+    std::lock_guard lock(m_meshRequestMutex);
+    m_meshRequests.push_back(entry.id);
+}
+
+// A request is held until it is meshCoalesceSeconds old, absorbing the requests that follow
+// it (a chunk finalizing next door usually changes light around it too), and until the four
+// neighbours are finalized, so borders are built once against their real blocks rather than
+// against air. Chunks whose neighbours never arrive, at the edge of the load area, go ahead
+// after meshNeighborWaitSeconds. Chunks next to the camera skip the coalescing window.
+void WorldStreamer::dispatch_meshing()
+{
+    {
+        std::lock_guard lock(m_meshRequestMutex);
+        for (auto& request : m_meshRequests)
+        {
+            m_meshWaiting.push_back({request, m_time});
+        }
+        m_meshRequests.clear();
+    }
+
+    const auto settings = config::streaming();
+    std::erase_if(m_meshWaiting, [&](const WaitingMesh& waiting) {
+        ChunkEntry* entry = m_chunks.resolve(waiting.entry);
+        if (!entry || entry->cancelled)
+        {
+            m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        const ChunkCoord coord = entry->coord();
+        if (entry->edited.exchange(false))
         {
-            if (strong->chunk->state() == ChunkState::Generating)
+            schedule_split_meshing(*entry);
+            return true;
+        }
+
+        const double age = m_time - waiting.since;
+        const bool urgent = is_urgent(coord);
+        if (!urgent && age < settings.meshCoalesceSeconds)
+            return false;
+        // Results already waiting for the GPU are over their cap; let the queue drain first.
+        if (!urgent && m_budget.over(MemoryCategory::Jobs))
+            return false;
+        if (age < settings.meshNeighborWaitSeconds && !neighbors_ready(coord))
+            return false;
+
+        if (urgent)
+            schedule_split_meshing(*entry);
+        else
+            enqueue_meshing(*entry);
+        return true;
+    });
+}
+
+bool WorldStreamer::neighbors_ready(const ChunkCoord& coord) const
+{
+    for (const ChunkCoord& neighbor : {ChunkCoord{coord.x + 1, coord.z}, ChunkCoord{coord.x - 1, coord.z}, ChunkCoord{coord.x, coord.z + 1}, ChunkCoord{coord.x, coord.z - 1}})
+    {
+        const ChunkEntry* entry = find_entry(neighbor);
+        if (!entry || entry->chunk->state() == ChunkState::Generating)
+            return false;
+    }
+    return true;
+}
+
+void WorldStreamer::enqueue_meshing(ChunkEntry& entry, bool urgent)
+{
+    auto job = [this, handle = entry.id, urgent]() {
+        core::EpochGuard guard(m_epochs);
+        ChunkEntry* strong = m_chunks.resolve(handle);
+        if (!strong || strong->cancelled)
+        {
+            m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Dirty state is taken before the chunk is read so an edit landing mid-job
+        // re-dirties it and the chunk is meshed again once this job's result lands.
+        MeshUpload upload;
+        upload.entry = handle;
+        upload.coord = strong->chunk->coord();
+        upload.urgent = urgent;
+        upload.parts = take_mesh_parts(*strong);
+        upload.version = strong->dataVersion.load();
+        if (!build_mesh(*strong, upload))
+            return;
+
+        std::lock_guard lock(m_uploadMutex);
+        m_pendingUploads.push_back(std::move(upload));
+    };
+
+    if (urgent)
+        m_meshingJobs.enqueue_urgent(std::move(job));
+    else
+        m_meshingJobs.enqueue(std::move(job));
+}
+
+// Every part if the chunk itself changed (or nothing is marked at all) or its mesh gave up
+// memory, otherwise only the border strips whose neighbour changed.
+std::uint8_t WorldStreamer::take_mesh_parts(ChunkEntry& entry)
+{
+    bool changed = false;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        changed |= entry.chunk->take_dirty(lod);
+    }
+    const std::uint8_t borders = entry.dirtyBorders.exchange(0);
+    return changed || borders == 0 || !entry.mesh.complete() ? AllMeshParts : borders;
+}
+
+// Builds the parts named by upload.parts at every LOD. Returns false, with the upload released,
+// if the chunk was unloaded meanwhile.
+bool WorldStreamer::build_mesh(ChunkEntry& entry, MeshUpload& upload)
+{
+    m_meshJobs.fetch_add(1, std::memory_order_relaxed);
+    if (upload.parts != AllMeshParts)
+        m_borderMeshJobs.fetch_add(1, std::memory_order_relaxed);
+
+    const NeighborSet neighbors = gather_neighbors(upload.coord);
+
+    auto& scratch = GreedyMesher::worker_scratch();
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        // Each LOD is a natural point to give up on a chunk that has since been unloaded.
+        if (entry.cancelled)
+        {
+            release_upload(upload);
+            m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        for (int index = 0; index < MeshPartCount; ++index)
+        {
+            const auto part = static_cast<MeshPart>(index);
+            if (!(upload.parts & part_bit(part)))
+                continue;
+            for (const bool opaquePass : {true, false})
             {
-                strong->meshInFlight = false;
-                return;
+                auto& buffers = (opaquePass ? upload.opaque : upload.transparent)[lod][static_cast<std::size_t>(index)];
+                buffers = m_bufferPool.acquire(lod, opaquePass, part);
+                GreedyMesher::build_part(*entry.chunk, neighbors, lod, opaquePass, part, scratch, buffers.vertices, buffers.indices);
+                m_bufferPool.record_quads(lod, opaquePass, buffers.indices.size() / 6, part);
             }
+        }
+    }
+    return true;
+}
 
-            MeshUpload upload;
-            upload.coord = strong->chunk->coord();
+void WorldStreamer::schedule_split_meshing(ChunkEntry& entry)
+{
+    auto task = std::make_shared<SplitMeshTask>();
+    MeshUpload& upload = task->upload;
+    upload.parts = take_mesh_parts(entry);
+    if (upload.parts != AllMeshParts)
+    {
+        // A few border strips are too little work to split. They go back for the job to take
+        // along with anything marked in the meantime.
+        entry.dirtyBorders.fetch_or(upload.parts);
+        enqueue_meshing(entry, true);
+        return;
+    }
+    m_meshJobs.fetch_add(1, std::memory_order_relaxed);
+    upload.entry = entry.id;
+    upload.coord = entry.chunk->coord();
+    upload.version = entry.dataVersion.load();
+    upload.urgent = true;
 
-            const NeighborSet neighbors = gather_neighbors(upload.coord);
+    // Urgent sub-jobs jump the queue; pushing in reverse keeps orientation 0 at the front.
+    for (int orientation = GreedyMesher::OrientationCount - 1; orientation >= 0; --orientation)
+    {
+        m_meshingJobs.enqueue_urgent([this, task, orientation]() {
+            core::EpochGuard guard(m_epochs);
+            if (ChunkEntry* strong = m_chunks.resolve(task->upload.entry); strong && !strong->cancelled)
+            {
+                const NeighborSet neighbors = gather_neighbors(task->upload.coord);
+                auto& scratch = GreedyMesher::worker_scratch();
+                auto& pieces = task->interior[static_cast<std::size_t>(orientation)];
+                const MeshPart border = GreedyMesher::border_part(orientation);
+                for (std::uint8_t lod = 0; lod < 3; ++lod)
+                {
+                    for (int pass = 0; pass < 2; ++pass)
+                    {
+                        const bool opaquePass = pass == 0;
+                        auto& piece = pieces[lod * 2 + pass];
+                        piece = m_bufferPool.acquire(lod, opaquePass);
+                        GreedyMesher::build_interior(*strong->chunk, neighbors, lod, opaquePass, orientation, scratch, piece.vertices, piece.indices);
+                        if (border == MeshPart::Interior)
+                            continue;
 
-            for (std::uint8_t lod = 0; lod < 3; ++lod)
+                        // No other sub-job writes this orientation's strip.
+                        auto& strip = (opaquePass ? task->upload.opaque : task->upload.transparent)[lod][static_cast<std::size_t>(border)];
+                        strip = m_bufferPool.acquire(lod, opaquePass, border);
+                        GreedyMesher::build_part(*strong->chunk, neighbors, lod, opaquePass, border, scratch, strip.vertices, strip.indices);
+                        m_bufferPool.record_quads(lod, opaquePass, strip.indices.size() / 6, border);
+                    }
+                }
+            }
+
+            if (task->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
             {
-                auto& opaque = upload.opaque[lod];
-                auto& transparent = upload.transparent[lod];
-                GreedyMesher::build(*strong->chunk, neighbors, lod, true, opaque.vertices, opaque.indices);
-                GreedyMesher::build(*strong->chunk, neighbors, lod, false, transparent.vertices, transparent.indices);
+                finish_split_meshing(*task);
             }
+        });
+    }
+}
 
+void WorldStreamer::finish_split_meshing(SplitMeshTask& task)
+{
+    MeshUpload& upload = task.upload;
+    ChunkEntry* strong = m_chunks.resolve(upload.entry);
+    if (strong && strong->cancelled)
+        strong = nullptr;
+    if (!strong)
+        m_cancelledJobs.fetch_add(1, std::memory_order_relaxed);
+
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            const bool opaquePass = pass == 0;
+            auto& merged = (opaquePass ? upload.opaque : upload.transparent)[lod][static_cast<std::size_t>(MeshPart::Interior)];
+            if (strong)
+            {
+                merged = m_bufferPool.acquire(lod, opaquePass);
+            }
+            for (auto& pieces : task.interior)
+            {
+                auto& piece = pieces[lod * 2 + pass];
+                if (strong)
+                {
+                    append_buffers(merged, piece);
+                }
+                m_bufferPool.release(lod, opaquePass, std::move(piece));
+            }
+            // A cancelled job merged nothing, so there is no interior to learn from.
+            if (strong)
             {
-                std::lock_guard lock(m_uploadMutex);
-                m_pendingUploads.push_back(std::move(upload));
+                m_bufferPool.record_quads(lod, opaquePass, merged.indices.size() / 6);
             }
         }
-    });
+    }
+
+    if (!strong)
+    {
+        release_upload(upload);
+        return;
+    }
+
+    std::lock_guard lock(m_uploadMutex);
+    m_pendingUploads.push_back(std::move(upload));
 }
 
+// Results move from the workers into the upload queue as soon as they are finished, which also
+// frees the chunk to be meshed again; the queue then goes to the GPU within the frame's budget,
+// interleaved by priority with the LODs the last frame drew out of date. Lazy uploads left over
+// are dropped: the next gather_draw_commands asks again for whatever it still draws.
 void WorldStreamer::process_uploads()
 {
-    std::vector<MeshUpload> uploads;
+    receive_uploads();
+    m_uploadedBytes = 0;
+    if (m_uploadQueue.empty() && m_lazyUploads.empty())
+        return;
+
+    // Sorted worst first so the next upload pops off the back.
+    for (auto& upload : m_uploadQueue)
+    {
+        upload.priority = priority(upload.coord);
+    }
+    std::sort(m_uploadQueue.begin(), m_uploadQueue.end(), [](const MeshUpload& a, const MeshUpload& b) {
+        if (a.urgent != b.urgent)
+            return b.urgent;
+        return a.priority > b.priority;
+    });
+    for (auto& upload : m_lazyUploads)
+    {
+        upload.priority = priority(upload.coord);
+    }
+    std::sort(m_lazyUploads.begin(), m_lazyUploads.end(), [](const LazyUpload& a, const LazyUpload& b) {
+        return a.priority > b.priority;
+    });
+
+    const auto settings = config::streaming();
+    const double budgetSeconds = static_cast<double>(settings.uploadBudgetMs) / 1000.0;
+    core::Timer timer;
+    bool uploadedAny = false;
+    while (!m_uploadQueue.empty() || !m_lazyUploads.empty())
+    {
+        const bool lazy = m_uploadQueue.empty() ||
+                          (!m_uploadQueue.back().urgent && !m_lazyUploads.empty() && m_lazyUploads.back().priority < m_uploadQueue.back().priority);
+        const bool urgent = !lazy && m_uploadQueue.back().urgent;
+        const bool overBudget = m_uploadedBytes >= settings.uploadBudgetBytes || timer.elapsed_seconds() >= budgetSeconds;
+        if (overBudget && uploadedAny && !urgent)
+            break;
+
+        if (lazy)
+        {
+            uploadedAny |= apply_lazy_upload(m_lazyUploads.back());
+            m_lazyUploads.pop_back();
+            continue;
+        }
+        MeshUpload& upload = m_uploadQueue.back();
+        uploadedAny |= apply_upload(upload);
+        release_upload(upload);
+        m_uploadQueue.pop_back();
+    }
+    m_lazyUploads.clear();
+}
+
+void WorldStreamer::receive_uploads()
+{
+    // m_processingUploads is swapped in and out of the shared queue so neither vector loses
+    // its capacity between frames.
+    auto& uploads = m_processingUploads;
     {
         std::lock_guard lock(m_uploadMutex);
         uploads.swap(m_pendingUploads);
     }
 
-    if (uploads.empty())
-        return;
-
     for (auto& upload : uploads)
     {
-        auto entry = find_entry(upload.coord);
+        // Results for an entry that has left the grid belong to nobody, even if the same
+        // coordinate has been loaded again since.
+        ChunkEntry* entry = m_chunks.resolve(upload.entry);
         if (!entry)
+        {
+            ++m_droppedUploads;
+            release_upload(upload);
             continue;
+        }
 
-        for (std::uint8_t lod = 0; lod < 3; ++lod)
+        // A newer result replaces the parts it carries of one still waiting for the GPU, so a
+        // border patch lands on top of the mesh it patches.
+        auto queued = std::find_if(m_uploadQueue.begin(), m_uploadQueue.end(), [&](const MeshUpload& waiting) {
+            return waiting.entry == upload.entry;
+        });
+        if (queued != m_uploadQueue.end())
         {
-            entry->mesh.cpu_opaque(lod) = std::move(upload.opaque[lod]);
-            entry->mesh.cpu_transparent(lod) = std::move(upload.transparent[lod]);
-            entry->mesh.upload(lod);
-            entry->chunk->clear_dirty(lod);
+            if ((queued->parts & ~upload.parts) == 0)
+                ++m_droppedUploads;
+            merge_upload(*queued, upload);
         }
+        else
+        {
+            m_uploadQueue.push_back(std::move(upload));
+        }
+        finish_mesh_job(*entry);
+    }
+    uploads.clear();
+}
+
+// Returns false if the result was dropped instead.
+bool WorldStreamer::apply_upload(MeshUpload& upload)
+{
+    ChunkEntry* entry = m_chunks.resolve(upload.entry);
+    if (!entry)
+    {
+        ++m_droppedUploads;
+        return false;
+    }
+
+    // A chunk that changed again while this mesh was being built has a newer one on the way
+    // (finish_mesh_job saw the dirty flags). If the chunk already shows a mesh, the stale one
+    // is not worth uploading; a first mesh is always kept.
+    if (entry->chunk->state() == ChunkState::Uploaded && entry->dataVersion.load() != upload.version)
+    {
+        ++m_droppedUploads;
+        return false;
+    }
+
+    // A border patch built before the mesh gave up memory has nothing to patch any more.
+    if (upload.parts != AllMeshParts && !entry->mesh.complete())
+    {
+        ++m_droppedUploads;
+        entry->fullRemeshRequested = false;
+        request_full_remesh(*entry);
+        return false;
+    }
+    if (upload.parts == AllMeshParts)
+        entry->fullRemeshRequested = false;
 
-        entry->chunk->set_state(ChunkState::Uploaded);
-        entry->meshInFlight = false;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        // The mesh keeps the fresh parts; whatever it held before returns to the pool.
+        for (std::size_t index = 0; index < MeshPartCount; ++index)
+        {
+            if (upload.parts & part_bit(static_cast<MeshPart>(index)))
+            {
+                std::swap(entry->mesh.cpu_opaque(lod)[index], upload.opaque[lod][index]);
+                std::swap(entry->mesh.cpu_transparent(lod)[index], upload.transparent[lod][index]);
+            }
+        }
+        entry->mesh.mark_changed(lod, upload.parts);
     }
+    // Outside the render area the mesh stays on the CPU until gather_draw_commands draws it
+    // and asks for the one LOD it needs, so chunks that are never drawn never get GPU buffers.
+    if (m_meshes && in_render_area(entry->coord()))
+        m_uploadedBytes += entry->mesh.upload(*m_meshes);
+    entry->chunk->set_state(ChunkState::Uploaded);
+    return true;
 }
 
-void WorldStreamer::unload_far_chunks(const glm::vec3& cameraPosition)
+// Returns false if nothing was sent.
+bool WorldStreamer::apply_lazy_upload(const LazyUpload& upload)
 {
-    const auto settings = config::streaming();
-    const int unloadRadius = settings.loadRadius + 2;
-    const ChunkCoord cameraChunk = from_world(cameraPosition);
+    ChunkEntry* entry = m_chunks.resolve(upload.entry);
+    if (!entry || !m_meshes || entry->chunk->state() != ChunkState::Uploaded)
+        return false;
+    const std::size_t sent = entry->mesh.upload(*m_meshes, upload.lod);
+    m_uploadedBytes += sent;
+    return sent > 0;
+}
 
-    std::vector<ChunkCoord> toRemove;
+void WorldStreamer::release_upload(MeshUpload& upload)
+{
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
     {
-        std::shared_lock lock(m_chunkMutex);
-        for (const auto& [coord, entry] : m_chunks)
+        for (std::size_t index = 0; index < MeshPartCount; ++index)
         {
-            const int dx = coord.x - cameraChunk.x;
-            const int dz = coord.z - cameraChunk.z;
-            if (std::abs(dx) > unloadRadius || std::abs(dz) > unloadRadius)
+            const auto part = static_cast<MeshPart>(index);
+            m_bufferPool.release(lod, true, std::move(upload.opaque[lod][index]), part);
+            m_bufferPool.release(lod, false, std::move(upload.transparent[lod][index]), part);
+        }
+    }
+}
+
+// Moves from's parts into `into` and releases what they replace. A merged result is only as
+// current as its oldest part.
+void WorldStreamer::merge_upload(MeshUpload& into, MeshUpload& from)
+{
+    const bool replaced = (into.parts & ~from.parts) == 0;
+    into.version = replaced ? from.version : std::min(into.version, from.version);
+    into.urgent |= from.urgent;
+    into.parts |= from.parts;
+    for (std::uint8_t lod = 0; lod < 3; ++lod)
+    {
+        for (std::size_t index = 0; index < MeshPartCount; ++index)
+        {
+            if (from.parts & part_bit(static_cast<MeshPart>(index)))
             {
-                if (!entry->meshInFlight.load())
-                {
-                    toRemove.push_back(coord);
-                }
+                std::swap(into.opaque[lod][index], from.opaque[lod][index]);
+                std::swap(into.transparent[lod][index], from.transparent[lod][index]);
             }
         }
     }
+    release_upload(from);
+}
+
+// Nothing polls for dirty chunks: a chunk dirtied while its mesh job was in flight could not
+// schedule another one, so the job's owner reschedules it here. The flag is cleared before the
+// dirty flags are read, pairing with mark_dirty-then-schedule_meshing on the other side.
+void WorldStreamer::finish_mesh_job(ChunkEntry& entry)
+{
+    entry.meshInFlight = false;
+    const Chunk& chunk = *entry.chunk;
+    if (chunk.state() != ChunkState::Generating && (chunk.needs_remesh(0) || chunk.needs_remesh(1) || chunk.needs_remesh(2) || entry.dirtyBorders.load() != 0))
+        schedule_meshing(entry);
+}
+
+// Every version bump is followed by schedule_meshing, so a job that misses the dirty flags set
+// here still sees the chunk rescheduled.
+void WorldStreamer::invalidate_mesh(ChunkEntry& entry)
+{
+    entry.dataVersion.fetch_add(1);
+    entry.chunk->mark_dirty(0);
+    entry.chunk->mark_dirty(1);
+    entry.chunk->mark_dirty(2);
+}
 
-    if (!toRemove.empty())
+// Unloading never waits on jobs: the entry is retired rather than freed while they may still
+// hold it, they stop at their next cancellation check and their results are dropped in
+// process_uploads.
+void WorldStreamer::unload_chunks(const std::vector<ChunkCoord>& leaving)
+{
+    for (const ChunkCoord& coord : leaving)
     {
-        std::unique_lock lock(m_chunkMutex);
-        for (const auto& coord : toRemove)
+        ChunkEntry* entry = m_chunks.find(coord);
+        if (!entry)
+            continue;
+        entry->cancelled = true;
+        m_chunks.erase(coord);
+
+        // Finished chunks move to the warm cache and are compressed off the main thread, and
+        // the compressed record of an unsaved one goes on to the region files. A chunk still
+        // being restored goes back as it came, since its payload never changes; anything else
+        // mid-generation is cheaper to generate again.
+        if (entry->chunk->state() != ChunkState::Generating)
+        {
+            m_warmCache.insert_raw(entry->chunk, entry->decorations, m_regions && entry->unsaved);
+            m_generationJobs.enqueue([this, coord, chunk = entry->chunk]() {
+                if (auto unsaved = m_warmCache.compress(chunk))
+                    m_regions->save(coord, unsaved->record);
+            });
+        }
+        else if (entry->cached)
         {
-            m_chunks.erase(coord);
+            // Unsaved changes must survive the payload being evicted from the cache.
+            if (m_regions && entry->cached->unsaved)
+                m_regions->save(coord, entry->cached->record);
+            m_warmCache.insert(coord, entry->cached);
         }
     }
 }
 
-void WorldStreamer::update(const glm::vec3& cameraPosition)
+int WorldStreamer::observer_distance(const ChunkCoord& coord) const
 {
-    const auto settings = config::streaming();
-    const ChunkCoord cameraChunk = from_world(cameraPosition);
+    int best = std::numeric_limits<int>::max();
+    for (const Observer& observer : m_observers)
+    {
+        if (observer.center)
+            best = std::min(best, std::max(std::abs(coord.x - observer.center->x), std::abs(coord.z - observer.center->z)));
+    }
+    return best;
+}
+
+// Asked for at most once until a full mesh lands; the rebuild covers every part because the
+// mesh is incomplete (see take_mesh_parts).
+void WorldStreamer::request_full_remesh(ChunkEntry& entry)
+{
+    if (entry.fullRemeshRequested)
+        return;
+    entry.fullRemeshRequested = true;
+    schedule_meshing(entry);
+}
+
+void WorldStreamer::account_memory()
+{
+    std::size_t voxels = 0;
+    std::size_t cpuMeshes = 0;
+    std::size_t gpuVertices = m_farTerrain.gpu_vertex_bytes();
+    std::size_t gpuIndices = m_farTerrain.gpu_index_bytes();
+    m_chunks.for_each([&](const ChunkEntry& entry) {
+        voxels += sizeof(Chunk) + static_cast<std::size_t>(entry.chunk->allocated_sections()) * ChunkSection::StorageBytes;
+        cpuMeshes += entry.mesh.cpu_bytes();
+        gpuVertices += entry.mesh.gpu_vertex_bytes();
+        gpuIndices += entry.mesh.gpu_index_bytes();
+    });
+
+    const auto upload_bytes = [](const MeshUpload& upload) {
+        std::size_t bytes = 0;
+        for (std::uint8_t lod = 0; lod < 3; ++lod)
+        {
+            bytes += parts_bytes(upload.opaque[lod]) + parts_bytes(upload.transparent[lod]);
+        }
+        return bytes;
+    };
+    std::size_t jobs = m_bufferPool.pooled_bytes();
+    for (const MeshUpload& upload : m_uploadQueue)
+    {
+        jobs += upload_bytes(upload);
+    }
+    {
+        std::lock_guard lock(m_uploadMutex);
+        for (const MeshUpload& upload : m_pendingUploads)
+        {
+            jobs += upload_bytes(upload);
+        }
+    }
+
+    m_budget.set_used(MemoryCategory::Voxels, voxels);
+    m_budget.set_used(MemoryCategory::CpuMeshes, cpuMeshes);
+    m_budget.set_used(MemoryCategory::GpuVertices, gpuVertices);
+    m_budget.set_used(MemoryCategory::GpuIndices, gpuIndices);
+    m_budget.set_used(MemoryCategory::Jobs, jobs);
+}
+
+// Frees memory in the categories past their cap, in order of what it costs to get back:
+// pooled buffers, then slack in GPU buffers (nothing), then CPU copies of meshes already on
+// the GPU (border patches become full rebuilds), then the LODs a chunk is not drawn at (a
+// rebuild if it comes closer). Each step goes from the farthest chunks in and stops as soon
+// as the categories it helps are back under their caps. Voxels and job results are limited
+// where they are produced instead; see dispatch_generation and dispatch_meshing.
+void WorldStreamer::enforce_memory_budget()
+{
+    account_memory();
+
+    for (int index = 0; index < MemoryCategoryCount; ++index)
+    {
+        const auto category = static_cast<MemoryCategory>(index);
+        const auto bit = static_cast<std::uint8_t>(1u << index);
+        if (m_budget.over(category) && !(m_overCap & bit))
+        {
+            util::log().warn("Memory budget: %s at %zu KiB, over its cap of %zu KiB", category_name(category), m_budget.used(category) / 1024, m_budget.cap(category) / 1024);
+            m_overCap = static_cast<std::uint8_t>(m_overCap | bit);
+        }
+        else if (m_budget.used(category) < m_budget.cap(category) / 10 * 9)
+        {
+            m_overCap = static_cast<std::uint8_t>(m_overCap & ~bit);
+        }
+    }
+
+    if (m_budget.over(MemoryCategory::Jobs))
+        m_budget.set_used(MemoryCategory::Jobs, m_budget.used(MemoryCategory::Jobs) - std::min(m_bufferPool.trim(), m_budget.used(MemoryCategory::Jobs)));
 
-    // Maintain a toroidal set of chunks around the camera: load radius controls generation,
-    // while additional passes below handle mesh uploads and far chunk eviction.
-    const auto& offsets = load_order(settings.loadRadius);
-    for (const auto& offset : offsets)
+    const auto gpuOver = [this] {
+        return m_budget.over(MemoryCategory::GpuVertices) || m_budget.over(MemoryCategory::GpuIndices);
+    };
+    const auto cpuOver = [this] { return m_budget.over(MemoryCategory::CpuMeshes); };
+    if (!gpuOver() && !cpuOver())
+        return;
+
+    // Only chunks showing a mesh have one to give up.
+    std::vector<std::pair<int, ChunkEntry*>> farthest;
+    m_chunks.for_each([&](ChunkEntry& entry) {
+        const ChunkState state = entry.chunk->state();
+        if (state == ChunkState::Uploaded || state == ChunkState::Visible)
+            farthest.emplace_back(observer_distance(entry.coord()), &entry);
+    });
+    std::sort(farthest.begin(), farthest.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    const auto release = [&](const auto& pressing, const auto& step) {
+        for (auto& [distance, entry] : farthest)
+        {
+            if (!pressing())
+                return;
+            ChunkMesh& mesh = entry->mesh;
+            const std::size_t cpu = mesh.cpu_bytes();
+            const std::size_t vertices = mesh.gpu_vertex_bytes();
+            const std::size_t indices = mesh.gpu_index_bytes();
+            step(*entry, distance);
+            m_budget.set_used(MemoryCategory::CpuMeshes, m_budget.used(MemoryCategory::CpuMeshes) - (cpu - mesh.cpu_bytes()));
+            m_budget.set_used(MemoryCategory::GpuVertices, m_budget.used(MemoryCategory::GpuVertices) - (vertices - mesh.gpu_vertex_bytes()));
+            m_budget.set_used(MemoryCategory::GpuIndices, m_budget.used(MemoryCategory::GpuIndices) - (indices - mesh.gpu_index_bytes()));
+        }
+    };
+
+    release(gpuOver, [](ChunkEntry& entry, int) { entry.mesh.shrink_gpu(); });
+    release(cpuOver, [this](ChunkEntry& entry, int) {
+        if (entry.mesh.drop_cpu() > 0)
+            ++m_droppedCpuMeshes;
+    });
+    release([&] { return gpuOver() || cpuOver(); }, [this](ChunkEntry& entry, int distance) {
+        const std::uint8_t drawn = select_lod(distance);
+        for (std::uint8_t lod = 0; lod < 3; ++lod)
+        {
+            if (lod != drawn && entry.mesh.has_lod(lod))
+            {
+                entry.mesh.evict_lod(lod);
+                ++m_evictedLods;
+            }
+        }
+    });
+}
+
+ObserverId WorldStreamer::add_observer(const glm::vec3& position, int loadRadius)
+{
+    const int radius = std::max(loadRadius, 0);
+    m_observers.push_back(Observer{m_nextObserver++, radius, position, glm::vec3(0.0f, 0.0f, -1.0f), StreamingView(radius), std::nullopt});
+    m_observersChanged = true;
+    return m_observers.back().id;
+}
+
+void WorldStreamer::move_observer(ObserverId id, const glm::vec3& position, const glm::vec3& forward)
+{
+    if (Observer* observer = find_observer(id))
+    {
+        observer->position = position;
+        observer->forward = forward;
+    }
+}
+
+void WorldStreamer::remove_observer(ObserverId id)
+{
+    Observer* observer = find_observer(id);
+    if (!observer)
+        return;
+
+    if (observer->center)
     {
-        ChunkCoord coord{cameraChunk.x + offset.x, cameraChunk.z + offset.z};
-        auto entry = ensure_chunk(coord);
-        if (entry->chunk->state() == ChunkState::MeshPending || entry->chunk->needs_remesh(0) || entry->chunk->needs_remesh(1) ||
-            entry->chunk->needs_remesh(2))
+        std::vector<ChunkCoord> leaving;
+        disc_difference(*observer->center, std::nullopt, observer->loadRadius + UnloadMargin, leaving);
+        release_area(leaving);
+    }
+    std::erase_if(m_observers, [id](const Observer& candidate) { return candidate.id == id; });
+    m_observersChanged = true;
+}
+
+WorldStreamer::Observer* WorldStreamer::find_observer(ObserverId id)
+{
+    auto found = std::find_if(m_observers.begin(), m_observers.end(), [id](const Observer& observer) { return observer.id == id; });
+    return found != m_observers.end() ? &*found : nullptr;
+}
+
+// An observer's area only changes when it crosses into another chunk. Only the strip of
+// coordinates that entered its load disc is created and only the strip that left its unload
+// disc is released; chunks still covered by another observer stay. New chunks wait in the
+// backlog, and from there move through generation, meshing and upload on their own.
+void WorldStreamer::move_area(Observer& observer, const ChunkCoord& center)
+{
+    std::vector<ChunkCoord> strip;
+    disc_difference(center, observer.center, observer.loadRadius + UnloadMargin, strip);
+    for (const ChunkCoord& coord : strip)
+    {
+        ++m_interest[coord];
+    }
+
+    strip.clear();
+    disc_difference(center, observer.center, observer.loadRadius, strip);
+    for (const ChunkCoord& coord : strip)
+    {
+        ensure_chunk(coord);
+    }
+
+    if (observer.center)
+    {
+        strip.clear();
+        disc_difference(*observer.center, center, observer.loadRadius + UnloadMargin, strip);
+        release_area(strip);
+    }
+    observer.center = center;
+}
+
+void WorldStreamer::release_area(const std::vector<ChunkCoord>& coords)
+{
+    std::vector<ChunkCoord> leaving;
+    for (const ChunkCoord& coord : coords)
+    {
+        auto interest = m_interest.find(coord);
+        if (interest != m_interest.end() && --interest->second == 0)
         {
-            schedule_meshing(entry);
+            m_interest.erase(interest);
+            leaving.push_back(coord);
         }
     }
+    unload_chunks(leaving);
+}
+
+void WorldStreamer::update(const glm::vec3& cameraPosition, const glm::vec3& cameraForward, float dt)
+{
+    const auto settings = config::streaming();
+    if (!m_cameraObserver || !find_observer(*m_cameraObserver))
+        m_cameraObserver = add_observer(cameraPosition, settings.loadRadius);
+    move_observer(*m_cameraObserver, cameraPosition, cameraForward);
+
+    update(dt);
+
+    m_farTerrain.update(cameraPosition, from_world(cameraPosition), settings.renderRadius);
+}
+
+void WorldStreamer::update(float dt)
+{
+    // Entries retired by earlier frames are freed here, on the thread that owns their meshes.
+    m_epochs.collect();
+
+    m_time += static_cast<double>(dt);
+    for (auto& observer : m_observers)
+    {
+        observer.view.update(observer.position, observer.forward, dt);
+        const ChunkCoord center = from_world(observer.position);
+        if (observer.center != center)
+            move_area(observer, center);
+    }
 
     process_uploads();
-    unload_far_chunks(cameraPosition);
+    enforce_memory_budget();
+    dispatch_meshing();
+    dispatch_generation();
+}
+
+BlockID WorldStreamer::get_block(const glm::ivec3& worldPos) const
+{
+    if (worldPos.y < 0 || worldPos.y >= ChunkHeight)
+        return BlockAir;
+
+    const ChunkCoord coord = from_world(glm::vec3(worldPos));
+    const ChunkEntry* entry = find_entry(coord);
+    if (!entry || entry->chunk->state() == ChunkState::Generating)
+        return BlockAir;
+
+    return entry->chunk->get(worldPos.x - coord.x * ChunkWidth, worldPos.y, worldPos.z - coord.z * ChunkDepth);
+}
+
+bool WorldStreamer::set_block(const glm::ivec3& worldPos, BlockID id)
+{
+    if (worldPos.y < 0 || worldPos.y >= ChunkHeight)
+        return false;
+
+    const ChunkCoord coord = from_world(glm::vec3(worldPos));
+    ChunkEntry* entry = find_entry(coord);
+    if (!entry || entry->chunk->state() == ChunkState::Generating)
+        return false;
+
+    const int localX = worldPos.x - coord.x * ChunkWidth;
+    const int localZ = worldPos.z - coord.z * ChunkDepth;
+    entry->chunk->set(localX, worldPos.y, localZ, id);
+    entry->unsaved = true;
+
+    // Light settles on a generation worker first; the edited chunk and every chunk whose light
+    // changed are then remeshed as edits, and a neighbour sharing the edited border otherwise
+    // only rebuilds its strip along it.
+    m_generationJobs.enqueue_urgent([this, worldPos, coord, localX, localZ]() {
+        core::EpochGuard guard(m_epochs);
+        std::vector<ChunkCoord> borders;
+        if (localX == 0)
+            borders.push_back({coord.x - 1, coord.z});
+        if (localX == ChunkWidth - 1)
+            borders.push_back({coord.x + 1, coord.z});
+        if (localZ == 0)
+            borders.push_back({coord.x, coord.z - 1});
+        if (localZ == ChunkDepth - 1)
+            borders.push_back({coord.x, coord.z + 1});
+
+        std::vector<ChunkCoord> touched = {coord};
+        std::vector<LitBorder> litBorders;
+        m_light.update_block(worldPos, touched, litBorders);
+        remesh_chunks(touched, true);
+        remesh_borders(coord, borders, touched, true);
+        remesh_lit_borders(litBorders, touched, true);
+    });
+    return true;
+}
+
+std::optional<RaycastHit> WorldStreamer::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+    // Amanatides-Woo voxel traversal.
+    const glm::vec3 dir = glm::normalize(direction);
+    glm::ivec3 block(static_cast<int>(std::floor(origin.x)), static_cast<int>(std::floor(origin.y)), static_cast<int>(std::floor(origin.z)));
+    glm::ivec3 stepDir(0);
+    glm::vec3 tMax(0.0f);
+    glm::vec3 tDelta(0.0f);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (dir[axis] > 0.0f)
+        {
+            stepDir[axis] = 1;
+            tDelta[axis] = 1.0f / dir[axis];
+            tMax[axis] = (static_cast<float>(block[axis] + 1) - origin[axis]) * tDelta[axis];
+        }
+        else if (dir[axis] < 0.0f)
+        {
+            stepDir[axis] = -1;
+            tDelta[axis] = -1.0f / dir[axis];
+            tMax[axis] = (origin[axis] - static_cast<float>(block[axis])) * tDelta[axis];
+        }
+        else
+        {
+            tDelta[axis] = std::numeric_limits<float>::infinity();
+            tMax[axis] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    glm::ivec3 normal(0);
+    float travelled = 0.0f;
+    while (travelled <= maxDistance)
+    {
+        const BlockID id = get_block(block);
+        if (id != BlockAir && !has_flag(registry().flags(id), BlockFlags::Fluid))
+        {
+            return RaycastHit{block, normal};
+        }
+
+        int axis = 0;
+        if (tMax.y < tMax[axis])
+            axis = 1;
+        if (tMax.z < tMax[axis])
+            axis = 2;
+
+        travelled = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        block[axis] += stepDir[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -stepDir[axis];
+    }
+    return std::nullopt;
 }
 
 void WorldStreamer::gather_draw_commands(const renderer::Camera& camera,
@@ -268,47 +1412,73 @@ void WorldStreamer::gather_draw_commands(const renderer::Camera& camera,
 {
     opaque.clear();
     transparent.clear();
+    m_lazyUploads.clear();
+    if (!m_meshes)
+        return;
 
     const glm::vec3 cameraPos = camera.position();
     const auto settings = config::streaming();
     const int renderRadius = settings.renderRadius;
     const ChunkCoord center = from_world(cameraPos);
 
-    std::shared_lock lock(m_chunkMutex);
-    for (const auto& [coord, entry] : m_chunks)
-    {
-        const int dx = coord.x - center.x;
-        const int dz = coord.z - center.z;
-        if (std::abs(dx) > renderRadius || std::abs(dz) > renderRadius)
-            continue;
+    m_chunks.for_each([&](ChunkEntry& entry) {
+        const ChunkCoord coord = entry.coord();
+        if (!StreamingView::in_disc(coord, center, renderRadius))
+            return;
 
-        if (entry->chunk->state() != ChunkState::Uploaded)
-            continue;
+        if (entry.chunk->state() != ChunkState::Uploaded)
+            return;
 
-        const glm::vec3 position = entry->chunk->world_position();
+        // The mesh ends at the highest non-empty section, so the open sky above it is not
+        // tested; looking down on the terrain, that culls most of the column's height.
+        const int contentHeight = entry.chunk->content_height();
+        if (contentHeight == 0)
+            return;
+        const glm::vec3 position = entry.chunk->world_position();
         const glm::vec3 min = position;
-        const glm::vec3 max = position + glm::vec3(ChunkWidth, static_cast<float>(ChunkHeight), ChunkDepth);
+        const glm::vec3 max = position + glm::vec3(ChunkWidth, static_cast<float>(contentHeight), ChunkDepth);
         if (!frustum.intersects(min, max))
-            continue;
+            return;
 
-        const int manhattan = std::max(std::abs(dx), std::abs(dz));
-        const std::uint8_t lod = select_lod(manhattan);
+        const int manhattan = std::max(std::abs(coord.x - center.x), std::abs(coord.z - center.z));
+        std::uint8_t lod = select_lod(manhattan);
 
-        opaque.push_back(DrawCommand{entry->chunk.get(), &entry->mesh, lod});
-        transparent.push_back(DrawCommand{entry->chunk.get(), &entry->mesh, lod});
-    }
-}
+        // A LOD evicted while the chunk was farther away is rebuilt; until it lands the chunk
+        // is drawn at the nearest LOD it still has.
+        if (!entry.mesh.has_lod(lod))
+        {
+            request_full_remesh(entry);
+            std::uint8_t fallback = lod;
+            for (int step = 1; step < 3 && !entry.mesh.has_lod(fallback); ++step)
+            {
+                if (lod + step < 3 && entry.mesh.has_lod(static_cast<std::uint8_t>(lod + step)))
+                    fallback = static_cast<std::uint8_t>(lod + step);
+                else if (lod - step >= 0 && entry.mesh.has_lod(static_cast<std::uint8_t>(lod - step)))
+                    fallback = static_cast<std::uint8_t>(lod - step);
+            }
+            if (!entry.mesh.has_lod(fallback))
+                return;
+            lod = fallback;
+        }
 
-} // namespace world
+        // Meshes that landed while the chunk was outside the render area go up once it is
+        // drawn, one LOD at a time and within the upload budget; until then it draws whatever
+        // the GPU holds, possibly nothing.
+        if (!entry.mesh.gpu_current(lod))
+            m_lazyUploads.push_back({entry.id, coord, lod, 0.0f});
+
+        opaque.push_back(DrawCommand{entry.chunk.get(), &entry.mesh, lod});
+        transparent.push_back(DrawCommand{entry.chunk.get(), &entry.mesh, lod});
+    });
+}
 
 StreamerStats WorldStreamer::stats() const
 {
     StreamerStats stats;
-    std::shared_lock lock(m_chunkMutex);
-    stats.totalChunks = m_chunks.size();
-    for (const auto& [coord, entry] : m_chunks)
-    {
-        switch (entry->chunk->state())
+    m_chunks.for_each([&](const ChunkEntry& entry) {
+        ++stats.totalChunks;
+        stats.allocatedSections += static_cast<std::size_t>(entry.chunk->allocated_sections());
+        switch (entry.chunk->state())
         {
         case ChunkState::Unloaded:
             break;
@@ -328,15 +1498,38 @@ StreamerStats WorldStreamer::stats() const
             ++stats.uploaded;
             break;
         }
-        if (entry->meshInFlight.load())
+        if (entry.meshInFlight.load())
         {
             ++stats.meshing;
         }
-    }
+    });
     {
         std::lock_guard lockUploads(m_uploadMutex);
-        stats.pendingUploads = m_pendingUploads.size();
+        stats.pendingUploads = m_pendingUploads.size() + m_uploadQueue.size();
+    }
+    stats.pooledBuffers = m_bufferPool.pooled();
+    stats.farTiles = m_farTerrain.tile_count();
+    stats.farTilesPending = m_farTerrain.pending_tiles();
+    stats.cancelledJobs = m_cancelledJobs.load(std::memory_order_relaxed);
+    stats.droppedUploads = m_droppedUploads;
+    stats.uploadedBytes = m_uploadedBytes;
+    stats.warmChunks = m_warmCache.size();
+    stats.warmBytes = m_warmCache.bytes();
+    for (int category = 0; category < MemoryCategoryCount; ++category)
+    {
+        stats.memory[static_cast<std::size_t>(category)] = m_budget.used(static_cast<MemoryCategory>(category));
     }
+    stats.droppedCpuMeshes = m_droppedCpuMeshes;
+    stats.evictedLods = m_evictedLods;
+    stats.evictedChunks = m_evictedChunks;
+    stats.meshWaiting = m_meshWaiting.size();
+    stats.meshJobs = m_meshJobs.load(std::memory_order_relaxed);
+    stats.borderMeshJobs = m_borderMeshJobs.load(std::memory_order_relaxed);
+    stats.loadedChunks = m_loadedChunks.load(std::memory_order_relaxed);
+    stats.pendingWrites = m_regions ? m_regions->pending_writes() : 0;
+    stats.retiredEntries = m_epochs.retired();
+    stats.observers = m_observers.size();
+    stats.coveredChunks = m_interest.size();
     return stats;
 }
 
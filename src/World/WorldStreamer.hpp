@@ -1,25 +1,38 @@
 #pragma once
 
 #include "Chunk.hpp"
+#include "ChunkCache.hpp"
+#include "ChunkGrid.hpp"
 #include "ChunkMesh.hpp"
+#include "Decorator.hpp"
+#include "FarTerrain.hpp"
 #include "GreedyMesher.hpp"
 #include "LOD.hpp"
+#include "LightEngine.hpp"
+#include "MemoryBudget.hpp"
+#include "MeshBufferPool.hpp"
+#include "RegionStore.hpp"
+#include "StreamingView.hpp"
 #include "WorldGen.hpp"
 
 #include "Config.hpp"
+#include "Core/Epoch.hpp"
 #include "Core/JobSystem.hpp"
 #include "Renderer/Camera.hpp"
 #include "Renderer/Frustum.hpp"
+#include "Renderer/GpuMesh.hpp"
 
 #include <array>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
+#include <glm/vec3.hpp>
+
 namespace world
 {
 struct DrawCommand
@@ -29,6 +42,12 @@ struct DrawCommand
     std::uint8_t lod = 0;
 };
 
+struct RaycastHit
+{
+    glm::ivec3 block{0};
+    glm::ivec3 normal{0};
+};
+
 struct StreamerStats
 {
     std::size_t totalChunks = 0;
@@ -37,14 +56,67 @@ struct StreamerStats
     std::size_t uploaded = 0;
     std::size_t meshing = 0;
     std::size_t pendingUploads = 0;
+    std::size_t pooledBuffers = 0;
+    std::size_t farTiles = 0;
+    std::size_t farTilesPending = 0;
+    std::size_t cancelledJobs = 0;
+    // Mesh requests held back for coalescing or for their neighbours, chunk meshes built so
+    // far, and how many of those only rebuilt border strips.
+    std::size_t meshWaiting = 0;
+    std::size_t meshJobs = 0;
+    std::size_t borderMeshJobs = 0;
+    std::size_t droppedUploads = 0;
+    // Mesh data sent to the GPU in the last update().
+    std::size_t uploadedBytes = 0;
+    // Chunks held compressed in the warm cache and the memory they take.
+    std::size_t warmChunks = 0;
+    std::size_t warmBytes = 0;
+    // Sections of the loaded chunks that hold per-cell storage.
+    std::size_t allocatedSections = 0;
+    // Memory held per MemoryCategory as of the last update(), and what was given up to stay
+    // within the caps: CPU mesh copies dropped, LODs evicted and chunks sent to the warm cache
+    // early, counted since startup.
+    std::array<std::size_t, MemoryCategoryCount> memory{};
+    std::size_t droppedCpuMeshes = 0;
+    std::size_t evictedLods = 0;
+    std::size_t evictedChunks = 0;
+    // Chunks read from the region files instead of generated, and records waiting to be written.
+    std::size_t loadedChunks = 0;
+    std::size_t pendingWrites = 0;
+    // Unloaded entries not yet freed because a worker may still be reading them.
+    std::size_t retiredEntries = 0;
+    // Observers streamed around and the chunks their areas cover between them.
+    std::size_t observers = 0;
+    std::size_t coveredChunks = 0;
 };
 
+// A viewer the world is streamed around; identifiers are never reused.
+using ObserverId = std::uint32_t;
+
 class WorldStreamer
 {
   public:
-    WorldStreamer();
+    // Meshes are built on the CPU either way; they only reach the GPU, through `meshes`, for
+    // chunks in the camera's render area. Null runs the streamer headless.
+    explicit WorldStreamer(renderer::MeshFactory* meshes = nullptr);
+    // Writes every loaded or warm chunk with unsaved changes to the region files.
+    ~WorldStreamer();
 
-    void update(const glm::vec3& cameraPosition);
+    // Every observer keeps the chunks within its load radius loaded, and a chunk stays loaded
+    // while the area of any observer (load radius + UnloadMargin) covers it. Chunks shared by
+    // overlapping areas are generated, meshed and uploaded once, nearest to any observer
+    // first, so the work follows the union of the areas rather than the number of observers.
+    // The area is built on the next update(). Main thread only.
+    ObserverId add_observer(const glm::vec3& position, int loadRadius);
+    void move_observer(ObserverId id, const glm::vec3& position, const glm::vec3& forward);
+    void remove_observer(ObserverId id);
+
+    // Streams around every observer. Their forward vectors and dt feed the streaming
+    // priorities: chunks in view and ahead of an observer's motion are generated first.
+    void update(float dt);
+    // Single-viewer form: moves the camera's observer, added with the configured load radius
+    // on the first call, updates, and centers the far terrain on the camera.
+    void update(const glm::vec3& cameraPosition, const glm::vec3& cameraForward, float dt);
     void gather_draw_commands(const renderer::Camera& camera,
                               const renderer::Frustum& frustum,
                               std::vector<DrawCommand>& opaque,
@@ -52,8 +124,20 @@ class WorldStreamer
 
     void reload();
 
+    // Heightmap-only horizon beyond the voxel chunks; updated with the chunks in update().
+    const FarTerrain& far_terrain() const { return m_farTerrain; }
+
+    // Main thread only, like update(). Edits go straight to the owning chunk; once light has
+    // been re-propagated the chunk and any chunk whose light changed are remeshed on the
+    // latency-critical path, and a neighbour sharing the edited border rebuilds the strip of
+    // its mesh along it.
+    BlockID get_block(const glm::ivec3& worldPos) const;
+    bool set_block(const glm::ivec3& worldPos, BlockID id);
+    std::optional<RaycastHit> raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
     StreamerStats stats() const;
-    std::size_t pending_generation_jobs() const { return m_generationJobs.pending_jobs(); }
+    // Queued jobs plus chunks still waiting in the backlog; main thread only.
+    std::size_t pending_generation_jobs() const { return m_generationJobs.pending_jobs() + m_generationBacklog.size(); }
     std::size_t pending_meshing_jobs() const { return m_meshingJobs.pending_jobs(); }
 
   private:
@@ -62,32 +146,211 @@ class WorldStreamer
         ChunkPtr chunk;
         ChunkMesh mesh;
         std::atomic_bool meshInFlight{false};
+        std::atomic_bool edited{false};
+        // Written once by the decoration stage, read by the finalize stage of this chunk and
+        // its neighbours.
+        std::vector<BlockWrite> decorations;
+        std::atomic_bool finalizeQueued{false};
+        // Bumped whenever the chunk's own blocks or light change; a mesh job records the
+        // version it read.
+        std::atomic<std::uint32_t> dataVersion{0};
+        // Border strips (part_bit mask) to rebuild because only the neighbour across them
+        // changed. Patched onto the mesh shown, so they leave dataVersion alone.
+        std::atomic<std::uint8_t> dirtyBorders{0};
+        // Set once the entry leaves the grid; jobs still holding it stop at their next check.
+        std::atomic_bool cancelled{false};
+        // A full rebuild was asked for by request_full_remesh and has not landed yet; main
+        // thread only.
+        bool fullRemeshRequested = false;
+        // Payload from the warm cache when the chunk is restored rather than generated. Set
+        // before the generation job is queued and never written again.
+        std::shared_ptr<const CachedChunk> cached;
+        // Generated or edited since it was last read from or written to the region files.
+        std::atomic_bool unsaved{false};
+        // Set before the entry is stored and never changed.
+        ChunkHandle id;
+
+        ChunkCoord coord() const { return chunk->coord(); }
+        ChunkHandle handle() const { return id; }
     };
 
+    // Results go back to the exact entry that was meshed, never to whichever entry holds the
+    // coordinate by the time they land.
     struct MeshUpload
     {
+        ChunkHandle entry;
         ChunkCoord coord;
-        std::array<MeshBuffers, 3> opaque;
-        std::array<MeshBuffers, 3> transparent;
+        std::uint32_t version = 0;
+        // Built for an edit or right next to the camera; goes up regardless of the budget.
+        bool urgent = false;
+        // Upload order within the frame's budget, lower first; refreshed every frame.
+        float priority = 0.0f;
+        // The mesh parts (part_bit mask) this result carries; the chunk keeps its other parts.
+        std::uint8_t parts = AllMeshParts;
+        std::array<MeshParts, 3> opaque;
+        std::array<MeshParts, 3> transparent;
     };
 
-    std::shared_ptr<ChunkEntry> ensure_chunk(const ChunkCoord& coord);
-    std::shared_ptr<ChunkEntry> find_entry(const ChunkCoord& coord) const;
-    void schedule_generation(const std::shared_ptr<ChunkEntry>& entry);
-    void schedule_meshing(const std::shared_ptr<ChunkEntry>& entry);
+    // One LOD of a mesh that is drawn while its GPU copy is out of date.
+    struct LazyUpload
+    {
+        ChunkHandle entry;
+        ChunkCoord coord;
+        std::uint8_t lod = 0;
+        float priority = 0.0f;
+    };
+
+    // Shared by the per-orientation sub-jobs of one chunk. Each writes its border strip straight
+    // into the upload; the last sub-job to finish merges the interior pieces.
+    struct SplitMeshTask
+    {
+        MeshUpload upload;
+        std::array<std::array<MeshBuffers, 6>, GreedyMesher::OrientationCount> interior; // [orientation][lod * 2 + pass]
+        std::atomic_int remaining{GreedyMesher::OrientationCount};
+    };
+
+    // Entries returned by pointer stay valid while the caller holds an epoch guard on
+    // m_epochs, or until the next update() on the main thread, the only thread that retires them.
+    ChunkEntry* ensure_chunk(const ChunkCoord& coord);
+    ChunkEntry* find_entry(const ChunkCoord& coord) const;
+    void schedule_generation(ChunkEntry& entry);
+    void dispatch_generation();
+    bool evict_farther_than(int distance, std::vector<std::pair<int, ChunkEntry*>>& farthest, std::vector<ChunkCoord>& evicted);
+    bool restore_chunk(ChunkEntry& entry);
+    bool load_chunk(ChunkEntry& entry);
+    // The eight surrounding entries, or false if any is missing or not yet decorated.
+    using RingRefs = std::array<ChunkEntry*, 8>;
+    bool gather_decorated_ring(const ChunkCoord& coord, RingRefs& ring) const;
+    void try_finalize(ChunkEntry& entry);
+    void schedule_meshing(ChunkEntry& entry);
+    void dispatch_meshing();
+    bool neighbors_ready(const ChunkCoord& coord) const;
+    void enqueue_meshing(ChunkEntry& entry, bool urgent = false);
+    std::uint8_t take_mesh_parts(ChunkEntry& entry);
+    bool build_mesh(ChunkEntry& entry, MeshUpload& upload);
+    void schedule_split_meshing(ChunkEntry& entry);
+    void finish_split_meshing(SplitMeshTask& task);
+    void finish_mesh_job(ChunkEntry& entry);
+    void invalidate_mesh(ChunkEntry& entry);
+    void release_upload(MeshUpload& upload);
+    void merge_upload(MeshUpload& into, MeshUpload& from);
+    void receive_uploads();
+    bool apply_upload(MeshUpload& upload);
+    bool apply_lazy_upload(const LazyUpload& upload);
+    void remesh_chunks(const std::vector<ChunkCoord>& coords, bool edited);
+    void remesh_borders(const ChunkCoord& changed, const std::vector<ChunkCoord>& neighbors, const std::vector<ChunkCoord>& remeshed, bool edited);
+    void remesh_lit_borders(const std::vector<LitBorder>& borders, const std::vector<ChunkCoord>& remeshed, bool edited);
+    bool is_urgent(const ChunkCoord& coord) const;
+    bool in_render_area(const ChunkCoord& coord);
+    // Lowest StreamingView priority over the observers.
+    float priority(const ChunkCoord& coord) const;
+    // The chunks stay valid for as long as the caller's epoch guard is held.
     NeighborSet gather_neighbors(const ChunkCoord& coord) const;
     void process_uploads();
-    void unload_far_chunks(const glm::vec3& cameraPosition);
+    void unload_chunks(const std::vector<ChunkCoord>& leaving);
+    // Chebyshev distance in chunks to the nearest observer.
+    int observer_distance(const ChunkCoord& coord) const;
+    // Rebuilds every part of every LOD, for meshes that gave up memory (see ChunkMesh).
+    void request_full_remesh(ChunkEntry& entry);
+    void account_memory();
+    void enforce_memory_budget();
 
-    core::JobSystem m_generationJobs;
-    core::JobSystem m_meshingJobs;
+    struct Observer
+    {
+        ObserverId id = 0;
+        int loadRadius = 0;
+        glm::vec3 position{0.0f};
+        glm::vec3 forward{0.0f, 0.0f, -1.0f};
+        StreamingView view;
+        // Chunk the observer's area was last built around; unset until its first update().
+        std::optional<ChunkCoord> center;
+    };
+    Observer* find_observer(ObserverId id);
+    void move_area(Observer& observer, const ChunkCoord& center);
+    void release_area(const std::vector<ChunkCoord>& coords);
+
+    renderer::MeshFactory* m_meshes;
     WorldGenerator m_generator;
+    MeshBufferPool m_bufferPool;
+    LightEngine m_light;
+    FarTerrain m_farTerrain;
+
+    // Chunks stay loaded out to an observer's loadRadius + UnloadMargin.
+    static constexpr int UnloadMargin = 2;
+    // Entries leaving the grid are retired here and freed at the start of a later update(),
+    // on the main thread, once no job can still be reading them.
+    core::EpochDomain m_epochs;
+    ChunkGrid<ChunkEntry> m_chunks;
+    ChunkCache m_warmCache;
+    // Cold tier behind the warm cache; null when persistence is off.
+    std::unique_ptr<RegionStore> m_regions;
 
-    mutable std::shared_mutex m_chunkMutex;
-    std::unordered_map<ChunkCoord, std::shared_ptr<ChunkEntry>> m_chunks;
+    // Main thread only. m_interest counts, for every chunk covered by some observer's area,
+    // how many cover it; a chunk is unloaded when its count drops to zero.
+    std::vector<Observer> m_observers;
+    ObserverId m_nextObserver = 1;
+    std::optional<ObserverId> m_cameraObserver;
+    std::unordered_map<ChunkCoord, int> m_interest;
+    // Set when an observer is added or removed, so the backlog is ranked again.
+    bool m_observersChanged = false;
+
+    // Chunks created but not yet handed to the generation workers; main thread only.
+    struct WaitingChunk
+    {
+        ChunkHandle entry;
+        ChunkCoord coord;
+        float priority = 0.0f;
+    };
+    std::vector<WaitingChunk> m_generationBacklog;
+    bool m_backlogSorted = true;
+    // Terrain-and-decoration jobs queued or running; the backlog only feeds this many.
+    std::atomic_int m_generationInFlight{0};
+    int m_generationSlots;
 
-    std::mutex m_uploadMutex;
+    mutable std::mutex m_uploadMutex;
     std::vector<MeshUpload> m_pendingUploads;
+    std::vector<MeshUpload> m_processingUploads;
+
+    // Mesh requests from any thread, picked up by dispatch_meshing on the main thread, and
+    // the requests it holds back; see there.
+    struct WaitingMesh
+    {
+        ChunkHandle entry;
+        double since = 0.0;
+    };
+    std::mutex m_meshRequestMutex;
+    std::vector<ChunkHandle> m_meshRequests;
+    std::vector<WaitingMesh> m_meshWaiting;
+    // Sum of update() time steps; the clock for mesh requests.
+    double m_time = 0.0;
+    // Finished meshes waiting for their turn on the GPU, at most one per chunk; main thread only.
+    std::vector<MeshUpload> m_uploadQueue;
+    // LODs gather_draw_commands drew while their GPU copy was behind the CPU one, for the next
+    // process_uploads to send within the same budget; main thread only.
+    std::vector<LazyUpload> m_lazyUploads;
+    std::size_t m_uploadedBytes = 0;
+
+    // Work skipped or abandoned because its chunk was unloaded, and mesh results dropped
+    // because the chunk changed again before they landed or a newer one replaced them.
+    std::atomic<std::size_t> m_cancelledJobs{0};
+    std::atomic<std::size_t> m_meshJobs{0};
+    std::atomic<std::size_t> m_borderMeshJobs{0};
+    std::size_t m_droppedUploads = 0;
+    std::atomic<std::size_t> m_loadedChunks{0};
+
+    // Main thread only; recounted and enforced by every update().
+    MemoryBudget m_budget;
+    // Categories reported over their cap (bit per MemoryCategory); a category is reported
+    // again only after falling well below its cap, not every time it brushes against it.
+    std::uint8_t m_overCap = 0;
+    std::size_t m_droppedCpuMeshes = 0;
+    std::size_t m_evictedLods = 0;
+    std::size_t m_evictedChunks = 0;
+
+    // Declared last so the workers are joined before any state their jobs touch is destroyed.
+    // Generation jobs queue meshing jobs, so the generation workers are joined first.
+    core::JobSystem m_meshingJobs;
+    core::JobSystem m_generationJobs;
 };
 
 } // namespace world